@@ -4,13 +4,13 @@
 
 #include "alien_movement_system.hpp"
 #include "components.hpp"
+#include "fixed_point.hpp"
 #include "rectangle.hpp"
 #include "sdl.hpp"
 #include <vector>
 
 using namespace std::chrono_literals;
 
-constexpr float ALIEN_SHUFFLE_DISTANCE = 200.0;
 constexpr float ALIEN_DROP_DISTANCE = 10.0;
 constexpr float ALIEN_SPEED_INCREMENT = 1.8;
 constexpr Duration MAX_STEP_DURATION = 500ms;
@@ -19,10 +19,13 @@ constexpr Duration MIN_STEP_DURATION = 50ms;
 void AlienMovementSystem::run(const std::set<Entity> &entities,
                               Coordinator &ecs, const Duration delta) {
   std::ignore = delta;
+  auto [positions, velocities, aliens, animations] =
+      componentStorage<Position, Velocity, Alien, Animation>(ecs);
+  const Duration step_time = stepTime();
   for (const auto &e : entities) {
-    auto &[pos] = ecs.getComponent<Position>(e);
-    auto &[vel] = ecs.getComponent<Velocity>(e);
-    const auto &start_x = ecs.getComponent<Alien>(e).start_x;
+    auto &[pos] = positions[e];
+    auto &[vel] = velocities[e];
+    const auto &start_x = aliens[e].start_x;
     if (pos.x < start_x) {
       pos.y += ALIEN_DROP_DISTANCE;
       vel.x = alien_speed;
@@ -30,16 +33,38 @@ void AlienMovementSystem::run(const std::set<Entity> &entities,
       pos.y += ALIEN_DROP_DISTANCE;
       vel.x = -alien_speed;
     }
-    ecs.getComponent<Animation>(e).step_time =
-        MIN_STEP_DURATION + (MAX_STEP_DURATION - MIN_STEP_DURATION) *
-      ((float)current_n_aliens / (float)initial_n_aliens);
+    animations[e].step_time = step_time;
   }
 
-  current_n_aliens = entities.size();
+  current_n_aliens = static_cast<uint32_t>(entities.size());
+  if (endless) {
+    return;
+  }
   if (current_n_aliens == 0) {
     events.push_back(GameEvent::Win);
   }
 
-  alien_speed = base_alien_speed +
-                ALIEN_SPEED_INCREMENT * (initial_n_aliens - current_n_aliens);
+  const auto n_destroyed = static_cast<int64_t>(initial_n_aliens) -
+                           static_cast<int64_t>(current_n_aliens);
+  if constexpr (FIXED_POINT) {
+    alien_speed = fromFixed(toFixed(base_alien_speed) +
+                            toFixed(ALIEN_SPEED_INCREMENT) * n_destroyed);
+  } else {
+    alien_speed = base_alien_speed +
+                  ALIEN_SPEED_INCREMENT * static_cast<float>(n_destroyed);
+  }
+}
+
+// Animations speed up as the aliens are destroyed.
+Duration AlienMovementSystem::stepTime() const {
+  if constexpr (FIXED_POINT) {
+    const auto min = std::chrono::round<Ticks>(MIN_STEP_DURATION).count();
+    const auto max = std::chrono::round<Ticks>(MAX_STEP_DURATION).count();
+    return Ticks(min + divideRounded((max - min) *
+                                         static_cast<int64_t>(current_n_aliens),
+                                     initial_n_aliens));
+  }
+  return MIN_STEP_DURATION + (MAX_STEP_DURATION - MIN_STEP_DURATION) *
+                                 ((float)current_n_aliens /
+                                  (float)initial_n_aliens);
 }
@@ -3,26 +3,38 @@
 
 #include "components.hpp"
 #include "game_event.hpp"
+#include "pipeline.hpp"
 #include "tecs.hpp"
 using namespace Tecs;
 // haha
 
-constexpr float ALIEN_INIT_SPEED = 12;
+// How far aliens go along before dropping & turning back.
+constexpr float ALIEN_SHUFFLE_DISTANCE = 200.0;
+
+struct AlienMovementSystem final : System {
+  static constexpr Stage STAGE = Stage::Control;
+  using Required = ComponentList<Alien, Position, Velocity>;
+  using Excluded = ComponentList<>;
 
-struct AlienMovementSystem : System {
   int initial_n_aliens;
   const float base_alien_speed;
   float alien_speed;
-  size_t current_n_aliens;
-  std::vector<GameEvent> &events;
-  AlienMovementSystem(const Signature &sig, Coordinator &coord,
-                      int initialNAliens, float alienSpeed,
-                      std::vector<GameEvent> &events)
-      : System(sig, coord), initial_n_aliens(initialNAliens),
+  uint32_t current_n_aliens;
+  GameEvents &events;
+  // Clearing the aliens doesn't win, and losing some doesn't speed the rest
+  // up: more arrive with the next wave.
+  bool endless;
+  AlienMovementSystem(Coordinator &coord, int initialNAliens, float alienSpeed,
+                      GameEvents &events, bool endless)
+      : System(signatureOf<AlienMovementSystem>(coord), coord),
+        initial_n_aliens(initialNAliens),
         base_alien_speed(alienSpeed), alien_speed(alienSpeed),
-        current_n_aliens(initialNAliens), events(events) {}
+        current_n_aliens(initialNAliens), events(events), endless(endless) {}
   void run(const std::set<Entity> &entities, Coordinator &ecs,
-           const Duration delta);
+           const Duration delta) override;
+
+private:
+  [[nodiscard]] Duration stepTime() const;
 };
 
 #endif // GAME_ALIEN_MOVEMENT_SYSTEM_HPP
@@ -0,0 +1,84 @@
+#include "allocation.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<size_t> allocation_count{0};
+
+void *countedAllocate(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) {
+    size = 1;
+  }
+  void *pointer = std::malloc(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *countedAllocate(size_t size, std::align_val_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  const auto align = static_cast<size_t>(alignment);
+  // aligned_alloc() requires the size to be a multiple of the alignment.
+  size = (size + align - 1) / align * align;
+  void *pointer = std::aligned_alloc(align, size == 0 ? align : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+} // namespace
+
+size_t allocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+// Replace the global allocation functions so every heap allocation made
+// through new (including by the standard library) is counted.
+void *operator new(size_t size) { return countedAllocate(size); }
+void *operator new[](size_t size) { return countedAllocate(size); }
+void *operator new(size_t size, std::align_val_t alignment) {
+  return countedAllocate(size, alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return countedAllocate(size, alignment);
+}
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t /*size*/) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void *pointer, size_t /*size*/) noexcept {
+  std::free(pointer);
+}
+void operator delete(void *pointer, std::align_val_t /*alignment*/) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void *pointer, std::align_val_t /*alignment*/) noexcept {
+  std::free(pointer);
+}
+void operator delete(void *pointer, size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void *pointer, size_t /*size*/,
+                       std::align_val_t /*alignment*/) noexcept {
+  std::free(pointer);
+}
+
+void AllocationTracker::endFrame() {
+  const size_t frame_allocations = allocationCount() - frame_start;
+  frames++;
+  allocations += frame_allocations;
+  if (frame_allocations > 0) {
+    allocating_frames++;
+  }
+}
+
+AllocationTracker::~AllocationTracker() {
+  printf("Heap allocations: %zu over %zu frames, %zu frames allocation-free\n",
+         allocations, frames, frames - allocating_frames);
+}
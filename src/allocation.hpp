@@ -0,0 +1,49 @@
+#ifndef GAME_ALLOCATION_HPP
+#define GAME_ALLOCATION_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+// Number of calls to the global operator new so far, on any thread.
+size_t allocationCount();
+
+// Counts the frames in which anything was allocated from the heap, and reports
+// on destruction.
+class AllocationTracker {
+public:
+  AllocationTracker() = default;
+  ~AllocationTracker();
+  AllocationTracker(const AllocationTracker &) = delete;
+  AllocationTracker &operator=(const AllocationTracker &) = delete;
+
+  void beginFrame() { frame_start = allocationCount(); }
+  void endFrame();
+
+private:
+  size_t frame_start = 0;
+  size_t frames = 0;
+  size_t allocating_frames = 0;
+  size_t allocations = 0;
+};
+
+// A bump allocator for data that only lives until the end of the frame.
+// Allocations come out of a fixed buffer, only falling back to the upstream
+// resource if it runs out.
+class FrameArena {
+public:
+  explicit FrameArena(std::pmr::memory_resource *upstream)
+      : arena(buffer.data(), buffer.size(), upstream) {}
+
+  std::pmr::memory_resource *resource() { return &arena; }
+  // Free everything at once: call at the end of each frame, once nothing
+  // allocated from it is still in use.
+  void reset() { arena.release(); }
+
+private:
+  static constexpr size_t SIZE = 4 * 1024;
+  std::array<std::byte, SIZE> buffer{};
+  std::pmr::monotonic_buffer_resource arena;
+};
+
+#endif // GAME_ALLOCATION_HPP
@@ -0,0 +1,165 @@
+#include "asset_loader.hpp"
+#include "destructible.hpp"
+#include "sdl.hpp"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+AssetLoader::AssetLoader(SDL_Renderer *renderer)
+    : renderer(renderer), start(Clock::now()) {}
+
+AssetLoader::~AssetLoader() {
+  // Let the workers finish, so nothing is written after it's freed.
+  pool.reset();
+  for (auto &asset : assets) {
+    if (asset.loaded) {
+      continue;
+    }
+    if (asset.surface != nullptr) {
+      SDL_FreeSurface(asset.surface);
+    }
+    if (asset.sound != nullptr) {
+      Mix_FreeChunk(asset.sound);
+    }
+  }
+}
+
+AssetLoader::Id AssetLoader::requestTexture(std::string path) {
+  return request(Kind::Texture, std::move(path));
+}
+
+AssetLoader::Id AssetLoader::requestImage(std::string path) {
+  return request(Kind::Image, std::move(path));
+}
+
+AssetLoader::Id AssetLoader::requestSound(std::string path) {
+  return request(Kind::Sound, std::move(path));
+}
+
+AssetLoader::Id AssetLoader::request(Kind kind, std::string path) {
+  if (not pool.has_value()) {
+    pool.emplace(std::max(1U, std::thread::hardware_concurrency()));
+  }
+  auto &asset = assets.emplace_back(Asset{kind, std::move(path)});
+
+  pool->submit([this, &asset] {
+    const auto decode_start = Clock::now();
+    try {
+      switch (asset.kind) {
+      case Kind::Texture:
+        asset.surface = IMG_Load(asset.path.c_str());
+        if (asset.surface == nullptr) {
+          throw SDL::Error(__FILE__, __LINE__);
+        }
+        break;
+      case Kind::Image:
+        asset.surface = loadMaskImage(asset.path);
+        break;
+      case Kind::Sound:
+        asset.sound = Mix_LoadWAV(asset.path.c_str());
+        if (asset.sound == nullptr) {
+          throw SDL::Error(__FILE__, __LINE__);
+        }
+        break;
+      }
+    } catch (...) {
+      // Rethrown on the main thread, when it gets to this asset.
+      asset.failure = std::current_exception();
+    }
+
+    {
+      const std::scoped_lock lock(mutex);
+      last_decoded = Clock::now();
+      decode_work += last_decoded - decode_start;
+      decoded.push_back(&asset);
+    }
+    decode_finished.notify_one();
+  });
+  return assets.size() - 1;
+}
+
+bool AssetLoader::upload(Duration budget) {
+  const auto upload_start = Clock::now();
+  bool uploaded = false;
+  while (Clock::now() - upload_start < budget) {
+    Asset *asset = nullptr;
+    {
+      const std::scoped_lock lock(mutex);
+      if (decoded.empty()) {
+        break;
+      }
+      asset = decoded.front();
+      decoded.pop_front();
+    }
+
+    if (asset->failure) {
+      std::rethrow_exception(asset->failure);
+    }
+    if (asset->kind == Kind::Texture) {
+      asset->texture = SDL_CreateTextureFromSurface(renderer, asset->surface);
+      SDL_FreeSurface(asset->surface);
+      asset->surface = nullptr;
+      if (asset->texture == nullptr) {
+        throw SDL::Error(__FILE__, __LINE__);
+      }
+      n_uploads++;
+      uploaded = true;
+    }
+    asset->loaded = true;
+    n_loaded++;
+  }
+
+  if (uploaded) {
+    const Duration elapsed = Clock::now() - upload_start;
+    upload_time += elapsed;
+    longest_upload = std::max(longest_upload, elapsed);
+    n_upload_calls++;
+  }
+  if (done() && pool.has_value()) {
+    // The workers aren't needed until something else is requested.
+    pool.reset();
+    loaded_at = Clock::now();
+  }
+  return done();
+}
+
+void AssetLoader::finish() {
+  const auto wait_start = Clock::now();
+  while (not upload(Duration::max())) {
+    std::unique_lock lock(mutex);
+    decode_finished.wait(lock, [this] { return not decoded.empty(); });
+  }
+  blocked += Clock::now() - wait_start;
+}
+
+SDL_Texture *AssetLoader::texture(Id id) const {
+  return assets[id].loaded ? assets[id].texture : nullptr;
+}
+
+SDL_Surface *AssetLoader::image(Id id) const {
+  return assets[id].loaded ? assets[id].surface : nullptr;
+}
+
+Mix_Chunk *AssetLoader::sound(Id id) const {
+  return assets[id].loaded ? assets[id].sound : nullptr;
+}
+
+void AssetLoader::printTimings() const {
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  if (not loaded_at.has_value()) {
+    printf("Assets: %zu of %zu loaded\n", n_loaded, assets.size());
+    return;
+  }
+  printf("Assets: %zu decoded by %.1fms, from %.1fms of work on %u threads\n",
+         assets.size(), Milliseconds(last_decoded - start).count(),
+         Milliseconds(decode_work).count(),
+         std::max(1U, std::thread::hardware_concurrency()));
+  printf("Assets: %zu textures uploaded in %.1fms over %zu calls, at most "
+         "%.1fms in one\n",
+         n_uploads, Milliseconds(upload_time).count(), n_upload_calls,
+         Milliseconds(longest_upload).count());
+  printf("Assets: all loaded by %.1fms, blocking the main thread for %.1fms\n",
+         Milliseconds(*loaded_at - start).count(),
+         Milliseconds(blocked).count());
+}
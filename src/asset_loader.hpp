@@ -0,0 +1,97 @@
+#ifndef GAME_ASSET_LOADER_HPP
+#define GAME_ASSET_LOADER_HPP
+
+#include "thread_pool.hpp"
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// Loads files in the background. Images & sounds are decoded on worker
+// threads, in parallel. Textures can only be created on the thread that owns
+// the renderer, so decoded images are uploaded by calls to upload() from the
+// main thread, a bounded amount at a time, so that loading never holds up a
+// frame for long.
+class AssetLoader {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Id = size_t;
+
+  explicit AssetLoader(SDL_Renderer *renderer);
+  ~AssetLoader();
+  AssetLoader(const AssetLoader &) = delete;
+  AssetLoader &operator=(const AssetLoader &) = delete;
+
+  // Start loading an image, to be uploaded as a texture.
+  Id requestTexture(std::string path);
+  // Start loading an image, kept as an ARGB8888 surface (see loadMaskImage).
+  Id requestImage(std::string path);
+  Id requestSound(std::string path);
+
+  // Finish loading whatever has been decoded, until the budget is spent.
+  // Rethrows the error if anything failed to load. Returns whether everything
+  // requested has been loaded.
+  bool upload(Duration budget);
+  // Block until everything requested has been loaded.
+  void finish();
+  [[nodiscard]] bool done() const { return n_loaded == assets.size(); }
+
+  // Each is null until loaded. The caller becomes responsible for freeing
+  // images & sounds.
+  [[nodiscard]] SDL_Texture *texture(Id id) const;
+  [[nodiscard]] SDL_Surface *image(Id id) const;
+  [[nodiscard]] Mix_Chunk *sound(Id id) const;
+
+  void printTimings() const;
+
+private:
+  enum class Kind { Texture, Image, Sound };
+  struct Asset {
+    Kind kind;
+    std::string path;
+    // Written by a worker, then only read after it has been handed over.
+    SDL_Surface *surface = nullptr;
+    Mix_Chunk *sound = nullptr;
+    std::exception_ptr failure = nullptr;
+    // Main thread only.
+    SDL_Texture *texture = nullptr;
+    bool loaded = false;
+  };
+
+  SDL_Renderer *renderer;
+  // Stable references, so workers can fill in assets as more are requested.
+  std::deque<Asset> assets;
+  size_t n_loaded = 0;
+  // Only running while there is something to decode.
+  std::optional<ThreadPool> pool;
+
+  std::mutex mutex;
+  std::condition_variable decode_finished;
+  // Decoded, waiting to be handed over to the main thread.
+  std::deque<Asset *> decoded;
+
+  // For the report.
+  Clock::time_point start;
+  Clock::time_point last_decoded;
+  std::optional<Clock::time_point> loaded_at;
+  Duration decode_work = Duration::zero();
+  Duration upload_time = Duration::zero();
+  Duration longest_upload = Duration::zero();
+  Duration blocked = Duration::zero();
+  size_t n_uploads = 0;
+  size_t n_upload_calls = 0;
+
+  Id request(Kind kind, std::string path);
+};
+
+#endif // GAME_ASSET_LOADER_HPP
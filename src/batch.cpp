@@ -0,0 +1,155 @@
+#include "batch.hpp"
+#include "bot.hpp"
+#include "destructible.hpp"
+#include "prefab_data.hpp"
+#include "prefabs.hpp"
+#include "state_hash.hpp"
+#include "thread_pool.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+struct WorldResult {
+  uint32_t score = 0;
+  int level = 1;
+  uint64_t frames = 0;
+  bool game_over = false;
+  // Of the world when it stopped.
+  uint64_t state_hash = 0;
+};
+
+uint64_t worldSeed(uint64_t seed, size_t index) {
+  std::seed_seq sequence{static_cast<uint32_t>(seed),
+                         static_cast<uint32_t>(seed >> 32),
+                         static_cast<uint32_t>(index)};
+  std::array<uint32_t, 2> seeds{};
+  sequence.generate(seeds.begin(), seeds.end());
+  return (static_cast<uint64_t>(seeds[0]) << 32) | seeds[1];
+}
+
+WorldResult playWorld(const BatchOptions &options, const WorldAssets &assets,
+                      size_t index) {
+  const uint64_t seed = worldSeed(options.seed, index);
+  WorldResult result;
+  while (true) {
+    WorldConfig config;
+    config.level = result.level;
+    config.score = result.score;
+    config.seed = seed;
+    config.presented = false;
+    config.hit_stop = false;
+    World world(config, assets);
+
+    auto res = GameEvent::Progress;
+    while (res == GameEvent::Progress) {
+      const bool scripted = not options.script.empty();
+      if (result.frames >= options.max_frames ||
+          (scripted && result.frames >= options.script.size())) {
+        result.score = world.score();
+        result.state_hash = world.stateHash();
+        return result;
+      }
+      const Input input =
+          scripted ? options.script[result.frames] : botInput(world);
+      res = world.step(input, FRAME_DURATION);
+      result.frames++;
+    }
+
+    result.score = world.score();
+    if (res == GameEvent::GameOver) {
+      result.game_over = true;
+      result.state_hash = world.stateHash();
+      return result;
+    }
+    result.level++;
+  }
+}
+
+void printResults(const BatchOptions &options,
+                  std::vector<WorldResult> &results, double seconds) {
+  const uint64_t frames = std::accumulate(
+      results.begin(), results.end(), uint64_t{0},
+      [](uint64_t total, const WorldResult &r) { return total + r.frames; });
+  printf("Simulated %zu worlds on %zu threads: %llu frames in %.2fs "
+         "(%.0f frames/s)\n",
+         results.size(), options.threads,
+         static_cast<unsigned long long>(frames), seconds,
+         static_cast<double>(frames) / seconds);
+
+  // The same seed should give the same hash however many threads were used,
+  // and, built in fixed point, on any machine.
+  StateHash hash;
+  for (const auto &result : results) {
+    hash.value(result.state_hash);
+  }
+  printf("State hash: %016llx\n",
+         static_cast<unsigned long long>(hash.digest()));
+
+  std::ranges::sort(results, {}, &WorldResult::score);
+  auto quantile = [&results](double q) {
+    return results[static_cast<size_t>(q * (results.size() - 1))].score;
+  };
+  const double mean =
+      std::accumulate(results.begin(), results.end(), 0.0,
+                      [](double total, const WorldResult &r) {
+                        return total + r.score;
+                      }) /
+      static_cast<double>(results.size());
+  printf("Scores: min %u, quartiles %u/%u/%u, max %u, mean %.1f\n",
+         quantile(0), quantile(0.25), quantile(0.5), quantile(0.75),
+         quantile(1), mean);
+
+  const int max_level =
+      std::ranges::max(results, {}, &WorldResult::level).level;
+  std::vector<size_t> reached(max_level + 1);
+  size_t game_overs = 0;
+  for (const auto &result : results) {
+    reached[result.level]++;
+    game_overs += result.game_over ? 1 : 0;
+  }
+  printf("Levels reached:");
+  for (int level = 1; level <= max_level; ++level) {
+    printf(" %d: %zu", level, reached[level]);
+  }
+  printf("\nGame over: %zu, out of frames: %zu\n", game_overs,
+         results.size() - game_overs);
+}
+} // namespace
+
+void runBatch(const BatchOptions &options) {
+  if (options.worlds == 0) {
+    return;
+  }
+  const auto prefabs = PrefabFile::load("data/prefabs.txt");
+  if (not prefabs.has_value()) {
+    printf("Couldn't load the prefabs\n");
+    return;
+  }
+  // Nothing is drawn, but the barriers' shape still comes from their sprite.
+  WorldAssets assets;
+  assets.barrier_image = loadMaskImage("art/barrier.png");
+  assets.prefabs = &*prefabs;
+
+  std::vector<WorldResult> results(options.worlds);
+  const auto start = std::chrono::steady_clock::now();
+  {
+    ThreadPool pool(options.threads);
+    for (size_t i = 0; i < options.worlds; ++i) {
+      // Each job writes only its own result.
+      pool.submit([&options, &assets, &results, i] {
+        results[i] = playWorld(options, assets, i);
+      });
+    }
+    pool.wait();
+  }
+  SDL_FreeSurface(assets.barrier_image);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  printResults(options, results, elapsed.count());
+}
@@ -0,0 +1,27 @@
+#ifndef GAME_BATCH_HPP
+#define GAME_BATCH_HPP
+
+#include "input.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Many headless worlds, each playing from level 1 until game over or it runs
+// out of frames, simulated in parallel. Nothing is drawn or played, so SDL
+// needn't be initialised.
+struct BatchOptions {
+  size_t worlds = 1;
+  size_t threads = 1;
+  // Frames each world may simulate, over all of its levels.
+  uint64_t max_frames = 0;
+  // Each world's seed is derived from this and its index.
+  uint64_t seed = 0;
+  // Input for every frame, given to every world in turn. Worlds that run out
+  // stop as if out of frames. If empty, the bot plays instead.
+  std::span<const Input> script;
+};
+
+// Run the batch, then print how fast it ran & how the worlds did.
+void runBatch(const BatchOptions &options);
+
+#endif // GAME_BATCH_HPP
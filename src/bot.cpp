@@ -0,0 +1,38 @@
+#include "bot.hpp"
+#include "components.hpp"
+#include <cmath>
+
+Input botInput(World &world) {
+  const auto &handles = world.handles();
+  if (not handles.valid(world.player())) {
+    return {};
+  }
+  auto &ecs = world.ecs();
+  const auto &positions = ecs.getComponents<Position>();
+  const auto player_x = positions[handles.entity(world.player())].p.x;
+
+  // The lowest alien, or the nearest one of those if there is a tie.
+  bool found = false;
+  glm::vec2 target{};
+  for (uint32_t slot = 0; slot < handles.capacity(); ++slot) {
+    const auto entity = handles.slotEntity(slot);
+    if (entity == EntityHandles::NULL_ENTITY ||
+        not ecs.hasComponent<Alien>(entity)) {
+      continue;
+    }
+    const auto &p = positions[entity].p;
+    if (not found || p.y > target.y ||
+        (p.y == target.y &&
+         std::abs(p.x - player_x) < std::abs(target.x - player_x))) {
+      target = p;
+      found = true;
+    }
+  }
+
+  constexpr float TOLERANCE = 8;
+  return {
+      found && target.x < player_x - TOLERANCE,
+      found && target.x > player_x + TOLERANCE,
+      true,
+  };
+}
@@ -0,0 +1,11 @@
+#ifndef GAME_BOT_HPP
+#define GAME_BOT_HPP
+
+#include "input.hpp"
+#include "world.hpp"
+
+// A simple player for batch runs: it lines up under the lowest alien, and
+// fires whenever it can.
+Input botInput(World &world);
+
+#endif // GAME_BOT_HPP
@@ -0,0 +1,27 @@
+#ifndef GAME_COLLISION_BOUNDS_HPP
+#define GAME_COLLISION_BOUNDS_HPP
+
+#include "components.hpp"
+#include "rectangle.hpp"
+#include <SDL2/SDL_rect.h>
+#include <bitset>
+#include <glm/ext/vector_float2.hpp>
+
+using LayerMask = std::bitset<8>;
+
+struct CollisionBounds {
+  glm::vec2 spacing{};
+  LayerMask layer;
+  [[nodiscard]] inline Rectangle rectangle(const Position &pos) const {
+    return {pos.p.x - spacing.x, pos.p.y - spacing.y, spacing.x * 2,
+            spacing.y * 2};
+  }
+  [[nodiscard]] inline SDL_Rect sdl_rectangle(const Position &pos) const {
+    Rectangle box = rectangle(pos);
+    SDL_Rect sdl_rectangle = {static_cast<int>(box.x), static_cast<int>(box.y),
+                              static_cast<int>(box.w), static_cast<int>(box.h)};
+    return sdl_rectangle;
+  }
+};
+
+#endif // GAME_COLLISION_BOUNDS_HPP
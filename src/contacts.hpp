@@ -0,0 +1,38 @@
+#ifndef GAME_CONTACTS_HPP
+#define GAME_CONTACTS_HPP
+
+#include "collision_bounds.hpp"
+#include "rectangle.hpp"
+#include <algorithm>
+#include <glm/ext/vector_float2.hpp>
+#include <memory_resource>
+#include <tecs.hpp>
+#include <vector>
+
+using namespace Tecs;
+
+// Two entities found colliding. All of a frame's contacts are found before any
+// are resolved, and stay available to later systems until the next frame.
+struct Contact {
+  // If either is destructible, it is a.
+  Entity a;
+  Entity b;
+  // The layers they collided on.
+  LayerMask layers;
+  // The centre of their overlap.
+  glm::vec2 point;
+  // b hit a solid pixel of a, which is destructible.
+  bool destructible;
+};
+
+using Contacts = std::pmr::vector<Contact>;
+
+inline glm::vec2 overlapCentre(const Rectangle &a, const Rectangle &b) {
+  const float left = std::max(a.x, b.x);
+  const float right = std::min(a.x + a.w, b.x + b.w);
+  const float top = std::max(a.y, b.y);
+  const float bottom = std::min(a.y + a.h, b.y + b.h);
+  return {(left + right) / 2, (top + bottom) / 2};
+}
+
+#endif // GAME_CONTACTS_HPP
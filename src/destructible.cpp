@@ -0,0 +1,135 @@
+#include "destructible.hpp"
+#include "sdl.hpp"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+// Knocked out of a destructible by each hit, centred on the pixel hit.
+constexpr int CRATER_RADIUS = 2;
+constexpr std::array<uint64_t, 2 * CRATER_RADIUS + 1> CRATER = {
+    0b01110, 0b11111, 0b11111, 0b11111, 0b01110,
+};
+
+// Bits first to last - 1 set.
+constexpr uint64_t bitSpan(int first, int last) {
+  const auto width = last - first;
+  const uint64_t bits =
+      width >= MASK_MAX_WIDTH ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+  return bits << first;
+}
+
+SDL_Rect rectUnion(const SDL_Rect &a, const SDL_Rect &b) {
+  if (a.w <= 0 || a.h <= 0) {
+    return b;
+  }
+  const int x = std::min(a.x, b.x);
+  const int y = std::min(a.y, b.y);
+  return {x, y, std::max(a.x + a.w, b.x + b.w) - x,
+          std::max(a.y + a.h, b.y + b.h) - y};
+}
+} // namespace
+
+SDL_Rect Destructible::spriteArea(const Position &pos,
+                                  const Rectangle &area) const {
+  const float left = pos.p.x - static_cast<float>(width * scale) / 2;
+  const float top = pos.p.y - static_cast<float>(height * scale) / 2;
+  const auto pixel = static_cast<float>(scale);
+  const int x0 = std::max(0, static_cast<int>((area.x - left) / pixel));
+  const int y0 = std::max(0, static_cast<int>((area.y - top) / pixel));
+  const int x1 = std::min(
+      width, static_cast<int>(std::ceil((area.x + area.w - left) / pixel)));
+  const int y1 = std::min(
+      height, static_cast<int>(std::ceil((area.y + area.h - top) / pixel)));
+  return {x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+}
+
+std::optional<SDL_Point> Destructible::firstSolid(const SDL_Rect &area,
+                                                  bool downwards) const {
+  if (area.w <= 0 || area.h <= 0) {
+    return std::nullopt;
+  }
+  const uint64_t span = bitSpan(area.x, area.x + area.w);
+  for (int i = 0; i < area.h; ++i) {
+    const int y = downwards ? area.y + i : area.y + area.h - 1 - i;
+    const uint64_t hits = rows[y] & span;
+    if (hits != 0) {
+      return SDL_Point{std::countr_zero(hits), y};
+    }
+  }
+  return std::nullopt;
+}
+
+void Destructible::erode(SDL_Point centre) {
+  const int shift = centre.x - CRATER_RADIUS;
+  for (int i = 0; i < static_cast<int>(CRATER.size()); ++i) {
+    const int y = centre.y - CRATER_RADIUS + i;
+    if (y < 0 || y >= height) {
+      continue;
+    }
+    rows[y] &= ~(shift >= 0 ? CRATER[i] << shift : CRATER[i] >> -shift);
+  }
+
+  const int x0 = std::max(0, centre.x - CRATER_RADIUS);
+  const int y0 = std::max(0, centre.y - CRATER_RADIUS);
+  const int x1 = std::min(width, centre.x + CRATER_RADIUS + 1);
+  const int y1 = std::min(height, centre.y + CRATER_RADIUS + 1);
+  dirty = rectUnion(dirty, {x0, y0, x1 - x0, y1 - y0});
+}
+
+Destructible destructibleFromAlpha(const SDL_Surface *image, int width,
+                                   int height, int scale) {
+  Destructible destructible;
+  if (image != nullptr) {
+    width = image->w;
+    height = image->h;
+  }
+  destructible.width = std::min(width, MASK_MAX_WIDTH);
+  destructible.height = std::min(height, MASK_MAX_HEIGHT);
+  destructible.scale = scale;
+  // Drawn in full to begin with.
+  destructible.dirty = {0, 0, destructible.width, destructible.height};
+
+  for (int y = 0; y < destructible.height; ++y) {
+    if (image == nullptr) {
+      destructible.rows[y] = bitSpan(0, destructible.width);
+      continue;
+    }
+    const auto *row = reinterpret_cast<const uint32_t *>(
+        static_cast<const std::byte *>(image->pixels) + y * image->pitch);
+    for (int x = 0; x < destructible.width; ++x) {
+      constexpr uint32_t OPAQUE = 0x80;
+      if ((row[x] >> 24) >= OPAQUE) {
+        destructible.rows[y] |= uint64_t{1} << x;
+      }
+    }
+  }
+  return destructible;
+}
+
+SDL_Surface *loadMaskImage(const std::string &path) {
+  SDL_Surface *loaded = IMG_Load(path.c_str());
+  if (loaded == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  SDL_Surface *image =
+      SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+  SDL_FreeSurface(loaded);
+  if (image == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  return image;
+}
+
+SDL_Texture *createMaskTexture(SDL_Renderer *renderer,
+                               const SDL_Surface *image) {
+  SDL_Texture *texture =
+      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                        SDL_TEXTUREACCESS_STREAMING, image->w, image->h);
+  if (texture == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  return texture;
+}
@@ -0,0 +1,54 @@
+#ifndef GAME_DESTRUCTIBLE_HPP
+#define GAME_DESTRUCTIBLE_HPP
+
+#include "components.hpp"
+#include "rectangle.hpp"
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// One bit per pixel, a row per word, so a whole row of a rectangle can be
+// tested with a single AND.
+constexpr int MASK_MAX_WIDTH = 64;
+constexpr int MASK_MAX_HEIGHT = 32;
+using MaskRows = std::array<uint64_t, MASK_MAX_HEIGHT>;
+
+// A sprite that is knocked out pixel by pixel. Bit x of rows[y] is set while
+// pixel (x, y) of the sprite is solid. Only solid pixels collide.
+struct Destructible {
+  MaskRows rows{};
+  int width = 0;
+  int height = 0;
+  // Size of a sprite pixel in the world.
+  int scale = 1;
+  // Sprite pixels changed since the texture was last updated.
+  SDL_Rect dirty{};
+
+  // The sprite pixels under a rectangle in the world, clipped to the sprite.
+  [[nodiscard]] SDL_Rect spriteArea(const Position &pos,
+                                    const Rectangle &area) const;
+  // The first solid pixel in the area, scanning rows downwards or upwards.
+  [[nodiscard]] std::optional<SDL_Point> firstSolid(const SDL_Rect &area,
+                                                    bool downwards) const;
+  // Knock out a crater around a pixel.
+  void erode(SDL_Point centre);
+};
+
+// Solid where the image is mostly opaque. Without an image, the whole
+// width x height is solid.
+Destructible destructibleFromAlpha(const SDL_Surface *image, int width,
+                                   int height, int scale);
+
+// Load an image as ARGB8888, so masks can be made from its alpha and textures
+// redrawn from its pixels.
+SDL_Surface *loadMaskImage(const std::string &path);
+// A streaming texture the size of the image, for a destructible to be drawn
+// into as it is damaged.
+SDL_Texture *createMaskTexture(SDL_Renderer *renderer,
+                               const SDL_Surface *image);
+
+#endif // GAME_DESTRUCTIBLE_HPP
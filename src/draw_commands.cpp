@@ -0,0 +1,51 @@
+#include "draw_commands.hpp"
+#include <array>
+#include <cstddef>
+
+void DrawList::submit(SDL_Renderer *renderer) const {
+  for (const auto &command : sprites) {
+    SDL_RenderCopy(renderer, command.texture,
+                   command.whole_texture ? nullptr : &command.src,
+                   &command.dst);
+  }
+  for (const auto &[rect, colour] : fills) {
+    SDL_SetRenderDrawColor(renderer, colour.r, colour.g, colour.b, colour.a);
+    SDL_RenderFillRect(renderer, &rect);
+  }
+}
+
+void ParticleBatches::submit(SDL_Renderer *renderer) const {
+  // Youngest to oldest.
+  constexpr std::array<SDL_Color, N_PARTICLE_SHADES> SHADES = {{
+      {0xFF, 0xF0, 0x80, 0xFF},
+      {0xFF, 0xB0, 0x30, 0xFF},
+      {0xE0, 0x50, 0x10, 0xFF},
+      {0x80, 0x20, 0x10, 0xFF},
+  }};
+  for (size_t shade = 0; shade < N_PARTICLE_SHADES; ++shade) {
+    if (rects[shade].empty()) {
+      continue;
+    }
+    const auto &colour = SHADES[shade];
+    SDL_SetRenderDrawColor(renderer, colour.r, colour.g, colour.b, colour.a);
+    SDL_RenderFillRects(renderer, rects[shade].data(),
+                        static_cast<int>(rects[shade].size()));
+  }
+}
+
+void MaskUpdate::submit() const {
+  std::array<uint32_t, MASK_MAX_WIDTH * MASK_MAX_HEIGHT> pixels{};
+  for (int y = 0; y < region.h; ++y) {
+    const auto *source = reinterpret_cast<const uint32_t *>(
+        static_cast<const std::byte *>(image->pixels) +
+        (region.y + y) * image->pitch);
+    const uint64_t row = rows[region.y + y];
+    for (int x = 0; x < region.w; ++x) {
+      const int image_x = region.x + x;
+      pixels[y * region.w + x] =
+          ((row >> image_x) & 1) != 0 ? source[image_x] : 0;
+    }
+  }
+  SDL_UpdateTexture(texture, &region, pixels.data(),
+                    region.w * static_cast<int>(sizeof(uint32_t)));
+}
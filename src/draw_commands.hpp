@@ -0,0 +1,130 @@
+#ifndef GAME_DRAW_COMMANDS_HPP
+#define GAME_DRAW_COMMANDS_HPP
+
+#include "destructible.hpp"
+#include <SDL2/SDL_render.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Layers of the scene that are drawn into cached textures.
+enum class Layer : uint8_t {
+  Background, // The alien encroachment border.
+  Barriers,
+  Hud, // Level & score text.
+};
+constexpr size_t N_LAYERS = 3;
+
+struct SpriteCommand {
+  SDL_Texture *texture;
+  SDL_Rect src;
+  SDL_Rect dst;
+  bool whole_texture; // Ignore src.
+};
+struct FillCommand {
+  SDL_Rect rect;
+  SDL_Color colour;
+};
+
+// New contents for the damaged part of a destructible's texture: the image's
+// pixels where the mask is still solid, and transparent elsewhere.
+struct MaskUpdate {
+  SDL_Texture *texture;
+  const SDL_Surface *image; // ARGB8888, the size of the texture.
+  SDL_Rect region;
+  MaskRows rows;
+
+  void submit() const;
+};
+
+// Drawing operations captured from the ECS, so they can be submitted to SDL
+// away from the simulation. Fills are drawn after sprites.
+struct DrawList {
+  std::pmr::vector<SpriteCommand> sprites;
+  std::pmr::vector<FillCommand> fills;
+
+  explicit DrawList(std::pmr::memory_resource *memory)
+      : sprites(memory), fills(memory) {}
+
+  void sprite(SDL_Texture *texture, const SDL_Rect &dst) {
+    sprites.push_back({texture, {}, dst, true});
+  }
+  void sprite(SDL_Texture *texture, const SDL_Rect &src, const SDL_Rect &dst) {
+    sprites.push_back({texture, src, dst, false});
+  }
+  void fill(const SDL_Rect &rect, SDL_Color colour) {
+    fills.push_back({rect, colour});
+  }
+  // Keeps capacity, so steady-state frames don't allocate.
+  void clear() {
+    sprites.clear();
+    fills.clear();
+  }
+  void submit(SDL_Renderer *renderer) const;
+};
+
+// Particles as small squares, which fade through a few shades as they age.
+// Each shade is drawn with a single call.
+constexpr size_t N_PARTICLE_SHADES = 4;
+struct ParticleBatches {
+  std::array<std::pmr::vector<SDL_Rect>, N_PARTICLE_SHADES> rects;
+
+  explicit ParticleBatches(std::pmr::memory_resource *memory)
+      : rects{std::pmr::vector<SDL_Rect>(memory),
+              std::pmr::vector<SDL_Rect>(memory),
+              std::pmr::vector<SDL_Rect>(memory),
+              std::pmr::vector<SDL_Rect>(memory)} {}
+
+  void clear() {
+    for (auto &shade : rects) {
+      shade.clear();
+    }
+  }
+  void submit(SDL_Renderer *renderer) const;
+};
+
+// Everything needed to draw one frame.
+struct FrameCommands {
+  DrawList scene;
+  // Drawn over the scene.
+  ParticleBatches particles;
+  // Only the layers which changed this frame are filled in.
+  std::array<DrawList, N_LAYERS> layers;
+  std::array<bool, N_LAYERS> layer_dirty{};
+  // Applied before the layers are redrawn.
+  std::pmr::vector<MaskUpdate> mask_updates;
+
+  explicit FrameCommands(std::pmr::memory_resource *memory)
+      : scene(memory), particles(memory),
+        layers{DrawList(memory), DrawList(memory), DrawList(memory)},
+        mask_updates(memory) {}
+
+  void clear() {
+    scene.clear();
+    particles.clear();
+    layer_dirty.fill(false);
+    mask_updates.clear();
+  }
+};
+
+// The simulation fills the back frame while the front frame is being drawn.
+// They are only swapped while neither side is using them.
+class DrawCommandBuffers {
+public:
+  explicit DrawCommandBuffers(std::pmr::memory_resource *memory)
+      : frames{FrameCommands(memory), FrameCommands(memory)} {}
+
+  FrameCommands &back() { return frames[back_index]; }
+  [[nodiscard]] const FrameCommands &front() const {
+    return frames[1 - back_index];
+  }
+  void swap() { back_index = 1 - back_index; }
+
+private:
+  std::array<FrameCommands, 2> frames;
+  size_t back_index = 0;
+};
+
+#endif // GAME_DRAW_COMMANDS_HPP
@@ -0,0 +1,71 @@
+#include "entity_handles.hpp"
+
+Entity EntityHandles::create() {
+  const Entity entity = ecs.newEntity();
+
+  uint32_t slot;
+  if (free_slots.empty()) {
+    slot = static_cast<uint32_t>(slots.size());
+    slots.push_back({entity, 0});
+  } else {
+    slot = free_slots.back();
+    free_slots.pop_back();
+    slots[slot].entity = entity;
+  }
+
+  if (entity >= entity_slots.size()) {
+    entity_slots.resize(entity + 1, NO_SLOT);
+  }
+  entity_slots[entity] = slot;
+  return entity;
+}
+
+void EntityHandles::destroy(Entity entity) {
+  const auto slot = slotOf(entity);
+  if (slot == NO_SLOT) {
+    return;
+  }
+  ecs.queueDestroyEntity(entity);
+
+  entity_slots[entity] = NO_SLOT;
+  slots[slot].entity = NULL_ENTITY;
+  slots[slot].generation++;
+  free_slots.push_back(slot);
+}
+
+bool EntityHandles::restore(std::span<const uint32_t> generations,
+                            std::span<const uint32_t> free_list,
+                            std::span<const uint32_t> creation_order) {
+  // Entities already queued for destruction must go before their IDs can be
+  // reused.
+  ecs.destroyQueued();
+  for (const auto &slot : slots) {
+    if (slot.entity != NULL_ENTITY) {
+      ecs.destroyEntity(slot.entity);
+    }
+  }
+
+  slots.clear();
+  for (const auto generation : generations) {
+    slots.push_back({NULL_ENTITY, generation});
+  }
+  free_slots.assign(free_list.begin(), free_list.end());
+  entity_slots.clear();
+
+  bool ordered = true;
+  Entity previous = 0;
+  for (const auto slot : creation_order) {
+    const Entity entity = ecs.newEntity();
+    if (entity < previous) {
+      ordered = false;
+    }
+    previous = entity;
+
+    slots[slot].entity = entity;
+    if (entity >= entity_slots.size()) {
+      entity_slots.resize(entity + 1, NO_SLOT);
+    }
+    entity_slots[entity] = slot;
+  }
+  return ordered;
+}
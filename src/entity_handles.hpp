@@ -0,0 +1,100 @@
+#ifndef GAME_ENTITY_HANDLES_HPP
+#define GAME_ENTITY_HANDLES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <tecs.hpp>
+#include <vector>
+
+using namespace Tecs;
+
+// A reference to an entity that can tell when the entity has been destroyed,
+// even if its ID has since been reused.
+struct EntityHandle {
+  uint32_t index = std::numeric_limits<uint32_t>::max();
+  uint32_t generation = 0;
+
+  bool operator==(const EntityHandle &) const = default;
+};
+
+constexpr EntityHandle NULL_HANDLE{};
+
+// Creates & destroys entities, handing out generational handles to them.
+// Handle indices are slots taken from a LIFO free list, so the most recently
+// freed (and most likely cached) slot is reused first, and live slots stay
+// packed at the bottom of the table however long the level runs.
+class EntityHandles {
+public:
+  static constexpr Entity NULL_ENTITY = std::numeric_limits<Entity>::max();
+
+  EntityHandles(Coordinator &ecs, std::pmr::memory_resource *memory)
+      : ecs(ecs), slots(memory), free_slots(memory), entity_slots(memory) {}
+
+  Entity create();
+  // Queue the entity for destruction, invalidating its handles immediately.
+  // Destroying an entity twice is harmless.
+  void destroy(Entity entity);
+
+  // The current handle for a live entity, or NULL_HANDLE.
+  [[nodiscard]] EntityHandle handle(Entity entity) const {
+    const auto slot = slotOf(entity);
+    return slot == NO_SLOT ? NULL_HANDLE
+                           : EntityHandle{slot, slots[slot].generation};
+  }
+  [[nodiscard]] bool valid(EntityHandle handle) const {
+    return handle.index < slots.size() &&
+           slots[handle.index].generation == handle.generation;
+  }
+  // Only meaningful for valid handles.
+  [[nodiscard]] Entity entity(EntityHandle handle) const {
+    return slots[handle.index].entity;
+  }
+
+  // The number of slots ever used: an upper bound on live handle indices.
+  [[nodiscard]] size_t capacity() const { return slots.size(); }
+  // The number of live entities.
+  [[nodiscard]] size_t size() const { return slots.size() - free_slots.size(); }
+
+  // The raw table, for snapshots.
+  // The entity in a slot, or NULL_ENTITY if the slot is free.
+  [[nodiscard]] Entity slotEntity(uint32_t slot) const {
+    return slots[slot].entity;
+  }
+  [[nodiscard]] uint32_t slotGeneration(uint32_t slot) const {
+    return slots[slot].generation;
+  }
+  [[nodiscard]] std::span<const uint32_t> freeSlots() const {
+    return free_slots;
+  }
+  // Destroy every entity immediately, then rebuild the table from saved
+  // generations & free list, creating a new entity for each live slot in
+  // creation_order, which with free_list must name every slot exactly once.
+  // Returns false if the coordinator handed out entities in a different order
+  // to creation_order.
+  bool restore(std::span<const uint32_t> generations,
+               std::span<const uint32_t> free_list,
+               std::span<const uint32_t> creation_order);
+
+private:
+  static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+  struct Slot {
+    Entity entity;
+    uint32_t generation;
+  };
+
+  Coordinator &ecs;
+  std::pmr::vector<Slot> slots;
+  std::pmr::vector<uint32_t> free_slots;
+  // Indexed by Entity.
+  std::pmr::vector<uint32_t> entity_slots;
+
+  [[nodiscard]] uint32_t slotOf(Entity entity) const {
+    return entity < entity_slots.size() ? entity_slots[entity] : NO_SLOT;
+  }
+};
+
+#endif // GAME_ENTITY_HANDLES_HPP
@@ -0,0 +1,179 @@
+#include "environment.hpp"
+#include "destructible.hpp"
+#include "prefabs.hpp"
+#include "sdl.hpp"
+#include <SDL2/SDL_image.h>
+#include <stdexcept>
+
+namespace {
+SDL_Texture *loadTexture(SDL_Renderer *renderer, const std::string &path) {
+  SDL_Surface *image = IMG_Load(path.c_str());
+  if (image == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, image);
+  SDL_FreeSurface(image);
+  if (texture == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  return texture;
+}
+} // namespace
+
+Environment::Environment(const EnvironmentOptions &options)
+    : prefabs(PrefabFile::load(options.asset_directory + "/data/prefabs.txt")) {
+  if (not prefabs.has_value()) {
+    throw std::runtime_error("Couldn't load the prefabs");
+  }
+  assets.prefabs = &*prefabs;
+  const auto art = options.asset_directory + "/art/";
+  // Needed even without drawing, as it gives the barriers their shape.
+  assets.barrier_image = loadMaskImage(art + "barrier.png");
+  if (not options.raster) {
+    return;
+  }
+
+  surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32,
+                                           SDL_PIXELFORMAT_ARGB8888);
+  if (surface == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  renderer = SDL_CreateSoftwareRenderer(surface);
+  if (renderer == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  layer_cache.emplace(renderer, SDL_Rect{0, 0, WINDOW_WIDTH, WINDOW_HEIGHT});
+
+  // Textures belong to the renderer that made them, so the game's own can't
+  // be shared. The environment is silent, so needs no sounds.
+  assets.player = loadTexture(renderer, art + "player.png");
+  assets.aliens = {loadTexture(renderer, art + "alien1.png"),
+                   loadTexture(renderer, art + "alien2.png"),
+                   loadTexture(renderer, art + "alien3.png")};
+  for (auto &texture : assets.barriers) {
+    texture = createMaskTexture(renderer, assets.barrier_image);
+  }
+  assets.bullet = loadTexture(renderer, art + "bullet.png");
+  assets.enemy_bullet = loadTexture(renderer, art + "enemy-bullet.png");
+  assets.mothership = loadTexture(renderer, art + "mothership.png");
+}
+
+Environment::~Environment() {
+  observers.reset();
+  world.reset();
+  layer_cache.reset();
+  if (renderer != nullptr) {
+    // Also destroys the textures.
+    SDL_DestroyRenderer(renderer);
+  }
+  if (surface != nullptr) {
+    SDL_FreeSurface(surface);
+  }
+  SDL_FreeSurface(assets.barrier_image);
+}
+
+void Environment::startLevel(int level, uint32_t score) {
+  observers.reset();
+  world.reset();
+
+  WorldConfig config;
+  config.level = level;
+  config.score = score;
+  config.seed = seed;
+  config.presented = renderer != nullptr;
+  config.hit_stop = false;
+  world.emplace(config, assets);
+
+  observers.emplace(world->ecs());
+  observers->pipeline.run(world->ecs(), Duration::zero());
+  raster_drawn = false;
+}
+
+void Environment::reset(uint64_t new_seed) {
+  seed = new_seed;
+  game_over = false;
+  startLevel(1, 0);
+}
+
+StepResult Environment::step(const Action &action, int n_frames) {
+  StepResult result;
+  if (game_over) {
+    result.game_over = true;
+    return result;
+  }
+
+  // The score is carried over between levels.
+  const auto start_score = world->score();
+  while (result.frames < n_frames) {
+    const auto res = world->step(action, FRAME_DURATION);
+    result.frames++;
+    if (layer_cache.has_value()) {
+      // Layers are only redrawn in the frames they change, so none can be
+      // skipped, even if the raster isn't looked at.
+      world->drawCommands().swap();
+      layer_cache->update(world->drawCommands().front());
+    }
+
+    if (res == GameEvent::GameOver) {
+      game_over = true;
+      result.game_over = true;
+      break;
+    }
+    if (res == GameEvent::Win) {
+      result.level_won = true;
+      startLevel(world->level() + 1, world->score());
+      break;
+    }
+  }
+  result.reward = world->score() - start_score;
+
+  observers->pipeline.run(world->ecs(), FRAME_DURATION);
+  raster_drawn = false;
+  return result;
+}
+
+Observation Environment::observe() {
+  auto &ecs = world->ecs();
+  return {
+      ecs.getComponents<Position>(),
+      ecs.getComponents<Velocity>(),
+      ecs.getComponents<Health>(),
+      ecs.getComponents<CollisionBounds>(),
+      *observers->player.entities,
+      *observers->aliens.entities,
+      *observers->mothership.entities,
+      *observers->bullets.entities,
+      world->contacts(),
+      world->score(),
+      world->level(),
+      world->frame(),
+  };
+}
+
+std::optional<Raster> Environment::raster() {
+  if (renderer == nullptr) {
+    return std::nullopt;
+  }
+
+  // Only drawn when asked for, as compositing the frame is the slow part.
+  if (not raster_drawn) {
+    const auto &frame = world->drawCommands().front();
+    SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+    SDL_RenderClear(renderer);
+    layer_cache->draw(Layer::Background);
+    layer_cache->draw(Layer::Barriers);
+    frame.scene.submit(renderer);
+    frame.particles.submit(renderer);
+    layer_cache->draw(Layer::Hud);
+    SDL_RenderFlush(renderer);
+    raster_drawn = true;
+  }
+
+  return Raster{
+      {static_cast<const std::byte *>(surface->pixels),
+       static_cast<size_t>(surface->pitch) * surface->h},
+      surface->w,
+      surface->h,
+      surface->pitch,
+  };
+}
@@ -0,0 +1,159 @@
+#ifndef GAME_ENVIRONMENT_HPP
+#define GAME_ENVIRONMENT_HPP
+
+#include "collision_bounds.hpp"
+#include "components.hpp"
+#include "contacts.hpp"
+#include "input.hpp"
+#include "pipeline.hpp"
+#include "prefab_data.hpp"
+#include "render_layers.hpp"
+#include "world.hpp"
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// The game as an environment for agents & test harnesses to drive. Steps
+// simulate a fixed frame time without waiting on a clock, so they run as
+// fast as the simulation allows.
+
+// An action is held for every frame of a step.
+using Action = Input;
+
+// Keeps a view of the entities matching its signature, without copying them.
+template <class RequiredComponents, class ExcludedComponents = ComponentList<>>
+struct EntityObserver final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = RequiredComponents;
+  using Excluded = ExcludedComponents;
+
+  const std::set<Entity> *entities = nullptr;
+
+  explicit EntityObserver(Coordinator &coord)
+      : System(signatureOf<EntityObserver>(coord), coord) {}
+
+  void run(const std::set<Entity> &matching, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = ecs;
+    std::ignore = delta;
+    entities = &matching;
+  }
+};
+
+using PlayerObserver = EntityObserver<ComponentList<Player, Position, Health>>;
+using AlienObserver = EntityObserver<ComponentList<Alien, Position, Health>>;
+using MothershipObserver =
+    EntityObserver<ComponentList<Mothership, Position, Health>>;
+// Anything else that moves & collides.
+using BulletObserver =
+    EntityObserver<ComponentList<Velocity, Position, CollisionBounds, Health>,
+                   ComponentList<Player, Alien, Mothership>>;
+
+// What the agent can see. Everything refers directly to the world's storage,
+// so is only valid until the next step or reset.
+struct Observation {
+  // Component storage, indexed by entity. Only the entries of the entities
+  // listed below are meaningful.
+  std::span<const Position> positions;
+  std::span<const Velocity> velocities;
+  std::span<const Health> healths;
+  // A bullet's layer tells whose it is: the player's hit layer 0x8.
+  std::span<const CollisionBounds> bounds;
+
+  // The player is empty once it has been destroyed.
+  const std::set<Entity> &player;
+  const std::set<Entity> &aliens;
+  const std::set<Entity> &mothership;
+  const std::set<Entity> &bullets;
+  // Collisions in the last frame simulated.
+  std::span<const Contact> contacts;
+
+  uint32_t score;
+  int level;
+  // Frames into the level.
+  uint64_t frame;
+};
+
+// Pixels of the last frame, drawn in software.
+struct Raster {
+  // ARGB8888, with rows pitch bytes apart.
+  std::span<const std::byte> pixels;
+  int width;
+  int height;
+  int pitch;
+};
+
+struct StepResult {
+  // Points scored during the step.
+  uint32_t reward = 0;
+  // Fewer than asked for if the game ended.
+  int frames = 0;
+  // The level was won, so the next one has started.
+  bool level_won = false;
+  // The game is over, and needs resetting.
+  bool game_over = false;
+};
+
+struct EnvironmentOptions {
+  // Draw every frame in software, so it can be observed with raster().
+  bool raster = false;
+  // Where the art directory is, for drawing.
+  std::string asset_directory = ".";
+};
+
+class Environment {
+public:
+  explicit Environment(const EnvironmentOptions &options = {});
+  ~Environment();
+  Environment(const Environment &) = delete;
+  Environment &operator=(const Environment &) = delete;
+
+  // Start a new game from level 1. Must be called before anything else.
+  void reset(uint64_t seed);
+  StepResult step(const Action &action, int n_frames = 1);
+
+  Observation observe();
+  // Only available if the environment was created with raster enabled.
+  std::optional<Raster> raster();
+
+private:
+  struct Observers {
+    PlayerObserver player;
+    AlienObserver aliens;
+    MothershipObserver mothership;
+    BulletObserver bullets;
+    Pipeline<PlayerObserver, AlienObserver, MothershipObserver, BulletObserver>
+        pipeline;
+
+    explicit Observers(Coordinator &ecs)
+        : player(ecs), aliens(ecs), mothership(ecs), bullets(ecs),
+          pipeline(player, aliens, mothership, bullets) {}
+  };
+
+  // Outlives the worlds made from it.
+  std::optional<PrefabFile> prefabs;
+  WorldAssets assets;
+  uint64_t seed = 0;
+  bool game_over = false;
+  std::optional<World> world;
+  // Destroyed before the world whose coordinator they belong to.
+  std::optional<Observers> observers;
+
+  // Software rendering, if enabled.
+  SDL_Surface *surface = nullptr;
+  SDL_Renderer *renderer = nullptr;
+  std::optional<LayerCache> layer_cache;
+  bool raster_drawn = false;
+
+  void startLevel(int level, uint32_t score);
+};
+
+#endif // GAME_ENVIRONMENT_HPP
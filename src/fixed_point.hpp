@@ -0,0 +1,143 @@
+#ifndef GAME_FIXED_POINT_HPP
+#define GAME_FIXED_POINT_HPP
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <glm/ext/vector_float2.hpp>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// Built with SPACE_INVADERS_FIXED_POINT, the simulation moves things in fixed
+// point, so a level plays out bit for bit the same whatever the compiler,
+// optimisation level or CPU. Positions & velocities are still stored as
+// floats, but only ever hold multiples of 1/256, which a float represents
+// exactly anywhere near the playing field, so the collision tests done on
+// them are exact too. Timers are still durations in double seconds, but only
+// ever advance by a whole number of microseconds, so their sums round the same
+// way everywhere. Random numbers come from the samplers below.
+#ifdef SPACE_INVADERS_FIXED_POINT
+constexpr bool FIXED_POINT = true;
+#else
+constexpr bool FIXED_POINT = false;
+#endif
+
+constexpr int FIXED_FRACTION_BITS = 8;
+constexpr float FIXED_ONE = 1 << FIXED_FRACTION_BITS;
+using Ticks = std::chrono::microseconds;
+
+// Scaling by a power of two is exact, so only the rounding can lose anything.
+inline int32_t toFixed(float value) {
+  return static_cast<int32_t>(std::lround(value * FIXED_ONE));
+}
+inline float fromFixed(int64_t value) {
+  return static_cast<float>(value) / FIXED_ONE;
+}
+
+// Rounds halves away from zero, unlike integer division.
+constexpr int64_t divideRounded(int64_t dividend, int64_t divisor) {
+  return (dividend >= 0 ? dividend + divisor / 2 : dividend - divisor / 2) /
+         divisor;
+}
+
+// The time a frame simulates, which is a whole number of ticks in fixed point.
+inline Duration simulationStep(Duration delta) {
+  if constexpr (FIXED_POINT) {
+    return std::chrono::round<Ticks>(delta);
+  }
+  return delta;
+}
+
+// Where something moving at velocity ends up after delta.
+inline glm::vec2 integrate(glm::vec2 position, glm::vec2 velocity,
+                           Duration delta) {
+  if constexpr (FIXED_POINT) {
+    constexpr int64_t TICKS_PER_SECOND = Ticks::period::den;
+    const int64_t ticks = std::chrono::round<Ticks>(delta).count();
+    auto axis = [ticks](float p, float v) {
+      return fromFixed(toFixed(p) + divideRounded(int64_t{toFixed(v)} * ticks,
+                                                  TICKS_PER_SECOND));
+    };
+    return {axis(position.x, velocity.x), axis(position.y, velocity.y)};
+  }
+  return position + velocity * static_cast<float>(delta.count());
+}
+
+// The same numbers as std::mt19937, but with its state laid out the same way
+// in every build, so it can be saved & hashed as plain bytes. The standard
+// library's keeps its words as uint_fast32_t, which is 8 bytes on some
+// platforms, alongside private members of its own.
+class MersenneTwister {
+public:
+  using result_type = uint32_t;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 0xFFFFFFFF; }
+
+  explicit MersenneTwister(uint32_t seed = 5489) {
+    state[0] = seed;
+    for (uint32_t i = 1; i < N; ++i) {
+      state[i] = 1812433253 * (state[i - 1] ^ (state[i - 1] >> 30)) + i;
+    }
+  }
+
+  result_type operator()() {
+    if (index == N) {
+      twist();
+    }
+    uint32_t y = state[index++];
+    y ^= y >> 11;
+    y ^= (y << 7) & 0x9D2C5680;
+    y ^= (y << 15) & 0xEFC60000;
+    return y ^ (y >> 18);
+  }
+
+private:
+  static constexpr uint32_t N = 624;
+  static constexpr uint32_t M = 397;
+  std::array<uint32_t, N> state{};
+  uint32_t index = N;
+
+  void twist() {
+    for (uint32_t i = 0; i < N; ++i) {
+      const uint32_t y =
+          (state[i] & 0x80000000) | (state[(i + 1) % N] & 0x7FFFFFFF);
+      state[i] =
+          state[(i + M) % N] ^ (y >> 1) ^ ((y & 1) != 0 ? 0x9908B0DF : 0);
+    }
+    index = 0;
+  }
+};
+
+// The standard fixes exactly what the engine outputs, but not how the std::
+// distributions turn that into numbers, and some use floating point, so the
+// simulation samples with these instead.
+
+// A whole number from low to high inclusive, each equally likely: outputs
+// past the last whole multiple of the range are drawn again.
+inline uint32_t uniformInt(MersenneTwister &gen, uint32_t low, uint32_t high) {
+  const uint64_t range = uint64_t{high} - low + 1;
+  const uint64_t limit = (uint64_t{1} << 32) / range * range;
+  uint64_t value = 0;
+  do {
+    value = gen();
+  } while (value >= limit);
+  return low + static_cast<uint32_t>(value % range);
+}
+
+// How many of a number of coin tosses come up heads: the set bits of 32
+// tosses at a time.
+inline int binomialHalf(MersenneTwister &gen, int trials) {
+  int heads = 0;
+  for (; trials >= 32; trials -= 32) {
+    heads += std::popcount(gen());
+  }
+  if (trials > 0) {
+    heads += std::popcount(gen() & ((1U << trials) - 1));
+  }
+  return heads;
+}
+
+#endif // GAME_FIXED_POINT_HPP
@@ -0,0 +1,147 @@
+#include "frame_capture.hpp"
+#include <SDL2/SDL_error.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+
+namespace {
+constexpr int BYTES_PER_PIXEL = 4;
+
+// BT.601, limited range, which is what Y4M readers assume.
+uint8_t lumaOf(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+uint8_t blueDifferenceOf(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+uint8_t redDifferenceOf(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+} // namespace
+
+FrameCapture::FrameCapture(SDL_Renderer *renderer,
+                           const CaptureOptions &options)
+    : renderer(renderer), options(options) {
+  this->options.every = std::max(1U, options.every);
+  this->options.buffers = std::max<size_t>(1, options.buffers);
+  if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0) {
+    return;
+  }
+  file = std::fopen(options.path.c_str(), "wb");
+  if (file == nullptr) {
+    return;
+  }
+
+  const auto frame_size = static_cast<size_t>(width) * height;
+  if (options.format == CaptureFormat::Y4M) {
+    const auto rate = std::lround(std::chrono::seconds(1) /
+                                  options.frame_period);
+    std::ignore = std::fprintf(file, "YUV4MPEG2 W%d H%d F%ld:%u Ip A1:1 C444\n",
+                               width, height, rate, this->options.every);
+    planes.resize(3 * frame_size);
+  }
+  ring.resize(this->options.buffers,
+              std::vector<uint8_t>(BYTES_PER_PIXEL * frame_size));
+  writer = std::thread([this] { writeFrames(); });
+}
+
+FrameCapture::~FrameCapture() {
+  if (writer.joinable()) {
+    {
+      const std::scoped_lock lock(mutex);
+      stopping = true;
+    }
+    frame_filled.notify_one();
+    writer.join();
+  }
+  if (file != nullptr) {
+    std::ignore = std::fclose(file);
+  }
+}
+
+void FrameCapture::capture() {
+  if (not good() || n_frames++ % options.every != 0) {
+    return;
+  }
+  {
+    std::unique_lock lock(mutex);
+    if (n_filled == ring.size()) {
+      if (options.drop_frames) {
+        n_dropped++;
+        return;
+      }
+      frame_written.wait(lock, [this] { return n_filled < ring.size(); });
+    }
+  }
+
+  // The writer only reads buffers once they are counted as filled.
+  auto &pixels = ring[next_write];
+  const SDL_Rect area = {0, 0, width, height};
+  if (SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_RGBA32,
+                           pixels.data(), width * BYTES_PER_PIXEL) != 0) {
+    printf("Couldn't capture a frame: %s\n", SDL_GetError());
+    n_dropped++;
+    return;
+  }
+  next_write = (next_write + 1) % ring.size();
+  {
+    const std::scoped_lock lock(mutex);
+    n_filled++;
+  }
+  frame_filled.notify_one();
+  n_captured++;
+}
+
+void FrameCapture::writeFrames() {
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      frame_filled.wait(lock, [this] { return stopping || n_filled > 0; });
+      // Whatever was captured is written before stopping.
+      if (n_filled == 0) {
+        return;
+      }
+    }
+
+    writeFrame(ring[next_read]);
+    next_read = (next_read + 1) % ring.size();
+    {
+      const std::scoped_lock lock(mutex);
+      n_filled--;
+    }
+    frame_written.notify_one();
+  }
+}
+
+void FrameCapture::writeFrame(const std::vector<uint8_t> &pixels) {
+  if (options.format == CaptureFormat::Raw) {
+    std::ignore = std::fwrite(pixels.data(), 1, pixels.size(), file);
+    return;
+  }
+
+  const size_t frame_size = pixels.size() / BYTES_PER_PIXEL;
+  uint8_t *luma = planes.data();
+  uint8_t *blue = luma + frame_size;
+  uint8_t *red = blue + frame_size;
+  for (size_t i = 0; i < frame_size; ++i) {
+    const int r = pixels[BYTES_PER_PIXEL * i];
+    const int g = pixels[BYTES_PER_PIXEL * i + 1];
+    const int b = pixels[BYTES_PER_PIXEL * i + 2];
+    luma[i] = lumaOf(r, g, b);
+    blue[i] = blueDifferenceOf(r, g, b);
+    red[i] = redDifferenceOf(r, g, b);
+  }
+  std::ignore = std::fputs("FRAME\n", file);
+  std::ignore = std::fwrite(planes.data(), 1, planes.size(), file);
+}
+
+void FrameCapture::printStatistics() const {
+  if (not good()) {
+    return;
+  }
+  printf("Capture: %llu %dx%d frames written to %s, %llu dropped while "
+         "writing fell behind\n",
+         static_cast<unsigned long long>(n_captured), width, height,
+         options.path.c_str(), static_cast<unsigned long long>(n_dropped));
+}
@@ -0,0 +1,83 @@
+#ifndef GAME_FRAME_CAPTURE_HPP
+#define GAME_FRAME_CAPTURE_HPP
+
+#include <SDL2/SDL_render.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <tecs.hpp>
+#include <thread>
+#include <vector>
+
+using namespace Tecs;
+
+enum class CaptureFormat {
+  // YUV4MPEG2, 4:4:4, which most video tools read directly.
+  Y4M,
+  // Bare RGBA frames one after another, with nothing to say how big they are.
+  Raw,
+};
+
+struct CaptureOptions {
+  std::string path;
+  CaptureFormat format = CaptureFormat::Y4M;
+  // Only keep every nth frame.
+  uint32_t every = 1;
+  // How many frames can wait to be written.
+  size_t buffers = 8;
+  // Drop frames while the writer is behind, rather than waiting for it. Only
+  // worth turning off when nobody is playing.
+  bool drop_frames = true;
+  // For the frame rate in the Y4M header.
+  Duration frame_period;
+};
+
+// Streams what the renderer draws to a file. Frames are read back into a ring
+// of buffers allocated up front, and written out by a thread of their own, so
+// the game only pays for the read back.
+class FrameCapture {
+public:
+  FrameCapture(SDL_Renderer *renderer, const CaptureOptions &options);
+  ~FrameCapture();
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  [[nodiscard]] bool good() const { return file != nullptr; }
+
+  // Read back the frame just drawn to the window: call before presenting it.
+  void capture();
+
+  void printStatistics() const;
+
+private:
+  SDL_Renderer *renderer;
+  CaptureOptions options;
+  int width = 0;
+  int height = 0;
+  FILE *file = nullptr;
+
+  // Filled by capture() at next_write, emptied by the writer at next_read.
+  std::vector<std::vector<uint8_t>> ring;
+  size_t next_write = 0;
+  size_t next_read = 0;
+  std::mutex mutex;
+  std::condition_variable frame_filled;
+  std::condition_variable frame_written;
+  size_t n_filled = 0;
+  bool stopping = false;
+
+  uint64_t n_frames = 0;
+  uint64_t n_captured = 0;
+  uint64_t n_dropped = 0;
+  // The writer's own.
+  std::vector<uint8_t> planes;
+  std::thread writer;
+
+  void writeFrames();
+  void writeFrame(const std::vector<uint8_t> &pixels);
+};
+
+#endif // GAME_FRAME_CAPTURE_HPP
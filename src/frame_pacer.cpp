@@ -0,0 +1,132 @@
+#include "frame_pacer.hpp"
+#include <SDL2/SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+// How long before the deadline to stop sleeping and start spinning: about the
+// worst wake-up latency of sleep_until() on a desktop OS.
+constexpr Duration SPIN_MARGIN = 2ms;
+// Menus have nothing animated, so only need redrawing occasionally.
+constexpr Duration IDLE_PERIOD = 250ms;
+// How close the refresh period must be to the frame period for vsync to pace
+// frames by itself.
+constexpr double VSYNC_TOLERANCE = 0.05;
+
+void DurationStatistics::add(Duration sample) {
+  min = std::min(min, sample);
+  max = std::max(max, sample);
+  total += sample;
+  count++;
+}
+
+void DurationStatistics::print(const char *name) const {
+  if (count == 0) {
+    return;
+  }
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  printf("%s: min %.2fms, mean %.2fms, max %.2fms over %zu samples\n", name,
+         Milliseconds(min).count(), Milliseconds(total / count).count(),
+         Milliseconds(max).count(), count);
+}
+
+FramePacer::FramePacer(SDL_Renderer *renderer, Duration period)
+    : period(period), deadline(Clock::now()) {
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer, &info) == 0) {
+    vsync = (info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+  }
+
+  SDL_DisplayMode mode;
+  if (vsync &&
+      SDL_GetWindowDisplayMode(SDL_RenderGetWindow(renderer), &mode) == 0 &&
+      mode.refresh_rate > 0) {
+    const Duration refresh_period = 1.0s / mode.refresh_rate;
+    paced_by_display =
+        std::abs(refresh_period / period - 1.0) < VSYNC_TOLERANCE;
+  }
+  printf("Vsync: %s, paced by display: %s\n", vsync ? "yes" : "no",
+         paced_by_display ? "yes" : "no");
+}
+
+void FramePacer::setIdle(bool is_idle) {
+  idle = is_idle;
+  deadline = Clock::now();
+  previous_present.reset();
+  pending_input.reset();
+  simulated_input.reset();
+  presenting_input.reset();
+}
+
+void FramePacer::waitForNextFrame() {
+  const auto now = Clock::now();
+  if (paced_by_display) {
+    deadline = now;
+    return;
+  }
+
+  deadline += std::chrono::duration_cast<Clock::duration>(period);
+  // Running behind: start the next frame now, rather than rushing several to
+  // catch up.
+  if (deadline <= now) {
+    deadline = now;
+    return;
+  }
+
+  std::this_thread::sleep_until(
+      deadline - std::chrono::duration_cast<Clock::duration>(SPIN_MARGIN));
+  while (Clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+bool FramePacer::waitEvent(SDL_Event &event) {
+  const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - Clock::now());
+  if (SDL_WaitEventTimeout(&event, std::max(0, (int)remaining.count())) != 0) {
+    return true;
+  }
+  deadline =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(IDLE_PERIOD);
+  return false;
+}
+
+void FramePacer::inputReceived(Uint32 timestamp) {
+  if (pending_input) {
+    return;
+  }
+  // Event timestamps are in SDL_GetTicks() milliseconds.
+  const auto age = std::chrono::milliseconds(SDL_GetTicks() - timestamp);
+  pending_input = Clock::now() - age;
+}
+
+void FramePacer::inputConsumed() {
+  simulated_input = pending_input;
+  pending_input.reset();
+}
+
+void FramePacer::presented() {
+  if (idle) {
+    return;
+  }
+  const auto now = Clock::now();
+  if (previous_present) {
+    frame_intervals.add(now - *previous_present);
+  }
+  previous_present = now;
+
+  // Simulation runs a frame ahead of presentation.
+  if (presenting_input) {
+    input_latencies.add(now - *presenting_input);
+  }
+  presenting_input = simulated_input;
+  simulated_input.reset();
+}
+
+void FramePacer::printStatistics() const {
+  frame_intervals.print("Frame interval");
+  input_latencies.print("Input-to-present latency");
+}
@@ -0,0 +1,71 @@
+#ifndef GAME_FRAME_PACER_HPP
+#define GAME_FRAME_PACER_HPP
+
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_render.h>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// Running minimum, mean & maximum of some durations.
+struct DurationStatistics {
+  Duration min = Duration::max();
+  Duration max = Duration::zero();
+  Duration total = Duration::zero();
+  size_t count = 0;
+
+  void add(Duration sample);
+  void print(const char *name) const;
+};
+
+// Decides when each frame starts. Active frames are paced by waiting on a
+// deadline: sleeping for most of the wait and spinning for the rest, since
+// sleep alone wakes up too late to give even frame times. If the display is
+// already pacing presentation through vsync at about the right rate, no
+// waiting is done at all. Idle frames (menus) are instead spent blocked
+// waiting for input, at a much lower rate.
+class FramePacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FramePacer(SDL_Renderer *renderer, Duration period);
+
+  // Switch between the active & idle frame rates.
+  void setIdle(bool is_idle);
+  // Block until the next active frame should start.
+  void waitForNextFrame();
+  // Block until an event arrives, or the next idle frame is due, in which case
+  // false is returned.
+  bool waitEvent(SDL_Event &event);
+
+  // Input-to-present latency is measured from the first input event in each
+  // frame, until the frame simulated with it is presented.
+  void inputReceived(Uint32 timestamp);
+  // The inputs received so far are being simulated, and will be presented in
+  // the next call to presented().
+  void inputConsumed();
+  void presented();
+
+  void printStatistics() const;
+
+private:
+  Duration period;
+  bool idle = false;
+  bool vsync = false;
+  // Presentation already blocks for about one period.
+  bool paced_by_display = false;
+  Clock::time_point deadline;
+
+  std::optional<Clock::time_point> pending_input;
+  std::optional<Clock::time_point> simulated_input;
+  std::optional<Clock::time_point> presenting_input;
+  std::optional<Clock::time_point> previous_present;
+
+  DurationStatistics frame_intervals;
+  DurationStatistics input_latencies;
+};
+
+#endif // GAME_FRAME_PACER_HPP
@@ -1,5 +1,9 @@
 #ifndef GAME_GAME_EVENT_HPP
 #define GAME_GAME_EVENT_HPP
+
+#include <memory_resource>
+#include <vector>
+
 enum class GameEvent {
   GameOver,
   Quit, // Called when player closes window.
@@ -9,4 +13,8 @@ enum class GameEvent {
   Win,
   Progress, // Go to the next scene
 };
+
+// What happened in a frame, in the world's per-frame scratch memory.
+using GameEvents = std::pmr::vector<GameEvent>;
+
 #endif // GAME_GAME_EVENT_HPP
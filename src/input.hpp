@@ -0,0 +1,22 @@
+#ifndef GAME_INPUT_HPP
+#define GAME_INPUT_HPP
+
+#include <SDL2/SDL_keyboard.h>
+
+// The player's controls, sampled once per frame on the main thread.
+struct Input {
+  bool left = false;
+  bool right = false;
+  bool fire = false;
+};
+
+inline Input sampleKeyboard() {
+  const auto *const keyboardState = SDL_GetKeyboardState(nullptr);
+  return {
+      keyboardState[SDL_SCANCODE_LEFT] != 0,
+      keyboardState[SDL_SCANCODE_RIGHT] != 0,
+      keyboardState[SDL_SCANCODE_SPACE] != 0,
+  };
+}
+
+#endif // GAME_INPUT_HPP
@@ -0,0 +1,85 @@
+#include "particles.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace {
+constexpr float GRAVITY = 200;
+// Fraction of speed lost per second.
+constexpr float DRAG = 1.5;
+constexpr int PARTICLE_SIZE = 2;
+} // namespace
+
+ParticlePool::ParticlePool(size_t capacity, uint32_t seed,
+                           std::pmr::memory_resource *memory)
+    : capacity(capacity), x(capacity, memory), y(capacity, memory),
+      vx(capacity, memory), vy(capacity, memory), age(capacity, memory),
+      lifespan(capacity, memory), rng(seed) {}
+
+void ParticlePool::emit(const Burst &burst) {
+  const size_t n = std::min(burst.count, capacity - count);
+  std::uniform_real_distribution<float> angles(0,
+                                               2 * std::numbers::pi_v<float>);
+  std::uniform_real_distribution<float> speeds(burst.min_speed,
+                                               burst.max_speed);
+  std::uniform_real_distribution<float> lifespans(burst.min_lifespan,
+                                                  burst.max_lifespan);
+  for (size_t i = count; i < count + n; ++i) {
+    const float angle = angles(rng);
+    const float speed = speeds(rng);
+    x[i] = burst.position.x;
+    y[i] = burst.position.y;
+    vx[i] = std::cos(angle) * speed;
+    vy[i] = std::sin(angle) * speed;
+    age[i] = 0;
+    lifespan[i] = lifespans(rng);
+  }
+  count += n;
+}
+
+void ParticlePool::update(Duration delta) {
+  const auto dt = static_cast<float>(delta.count());
+  const float drag = std::max(0.0F, 1.0F - DRAG * dt);
+  float *const px = x.data();
+  float *const py = y.data();
+  float *const pvx = vx.data();
+  float *const pvy = vy.data();
+  float *const page = age.data();
+  for (size_t i = 0; i < count; ++i) {
+    pvx[i] *= drag;
+    pvy[i] = pvy[i] * drag + GRAVITY * dt;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    px[i] += pvx[i] * dt;
+    py[i] += pvy[i] * dt;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    page[i] += dt;
+  }
+
+  for (size_t i = 0; i < count;) {
+    if (age[i] < lifespan[i]) {
+      ++i;
+      continue;
+    }
+    --count;
+    x[i] = x[count];
+    y[i] = y[count];
+    vx[i] = vx[count];
+    vy[i] = vy[count];
+    age[i] = age[count];
+    lifespan[i] = lifespan[count];
+  }
+}
+
+void ParticlePool::record(ParticleBatches &batches) const {
+  for (size_t i = 0; i < count; ++i) {
+    const auto shade = std::min(
+        N_PARTICLE_SHADES - 1,
+        static_cast<size_t>(age[i] / lifespan[i] * N_PARTICLE_SHADES));
+    batches.rects[shade].push_back(
+        {static_cast<int>(x[i]) - PARTICLE_SIZE / 2,
+         static_cast<int>(y[i]) - PARTICLE_SIZE / 2, PARTICLE_SIZE,
+         PARTICLE_SIZE});
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef GAME_PARTICLES_HPP
+#define GAME_PARTICLES_HPP
+
+#include "draw_commands.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm/ext/vector_float2.hpp>
+#include <memory_resource>
+#include <random>
+#include <tecs.hpp>
+#include <vector>
+
+using namespace Tecs;
+
+// Particles flung out from a point.
+struct Burst {
+  glm::vec2 position;
+  size_t count;
+  float min_speed;
+  float max_speed;
+  // In seconds.
+  float min_lifespan;
+  float max_lifespan;
+};
+
+// Short-lived cosmetic particles, kept out of the ECS. Each property is its
+// own array, so updates are simple loops the compiler can vectorise, and
+// dead particles are replaced by the last live one so the live ones stay
+// packed at the front. Nothing is allocated after construction.
+class ParticlePool {
+public:
+  ParticlePool(size_t capacity, uint32_t seed,
+               std::pmr::memory_resource *memory);
+
+  // Particles that don't fit are dropped.
+  void emit(const Burst &burst);
+  void update(Duration delta);
+  // Add every live particle to the batch for its shade.
+  void record(ParticleBatches &batches) const;
+
+  [[nodiscard]] size_t size() const { return count; }
+
+private:
+  size_t capacity;
+  size_t count = 0;
+  std::pmr::vector<float> x;
+  std::pmr::vector<float> y;
+  std::pmr::vector<float> vx;
+  std::pmr::vector<float> vy;
+  std::pmr::vector<float> age;
+  std::pmr::vector<float> lifespan;
+  // Only cosmetic, so its sequence needn't be saved.
+  std::minstd_rand rng;
+};
+
+#endif // GAME_PARTICLES_HPP
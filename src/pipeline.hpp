@@ -0,0 +1,88 @@
+#ifndef GAME_PIPELINE_HPP
+#define GAME_PIPELINE_HPP
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <tecs.hpp>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+using namespace Tecs;
+
+// The parts of a frame, in the order they must run.
+enum class Stage : uint8_t {
+  Control,     // Decide what entities want to do.
+  Movement,    // Move them.
+  Collision,   // React to where they ended up.
+  Destruction, // Queue entities for destruction.
+  Recording,   // Record draw commands for what's left.
+};
+
+template <class... Components> struct ComponentList {};
+
+// The storage of each component, indexed by entity. Look these up once per
+// run, instead of once per entity with getComponent().
+// Creating entities may reallocate the storage, invalidating references into
+// it, so only systems that don't create entities should hold on to them.
+template <class... Components>
+std::tuple<std::vector<Components> &...> componentStorage(Coordinator &ecs) {
+  return {ecs.getComponents<Components>()...};
+}
+
+template <class... Required, class... Excluded>
+Signature signatureOf(Coordinator &ecs, ComponentList<Required...> /*unused*/,
+                      ComponentList<Excluded...> /*unused*/) {
+  return componentsSignature({ecs.componentId<Required>()...},
+                             {ecs.componentId<Excluded>()...});
+}
+
+// A system whose stage and components are known at compile time. Systems
+// should be final, so runSystem() can call run() directly.
+template <class S>
+concept PipelineSystem = std::derived_from<S, System> && std::is_final_v<S> &&
+                         requires {
+                           { S::STAGE } -> std::convertible_to<Stage>;
+                           typename S::Required;
+                           typename S::Excluded;
+                         };
+
+// The signature of entities a system runs on.
+template <class S> Signature signatureOf(Coordinator &ecs) {
+  return signatureOf(ecs, typename S::Required{}, typename S::Excluded{});
+}
+
+// A fixed sequence of systems, run in order. The systems must be listed in
+// stage order, which is checked at compile time.
+template <PipelineSystem... Systems> class Pipeline {
+  static constexpr std::array<Stage, sizeof...(Systems)> STAGES = {
+      Systems::STAGE...};
+
+  static constexpr bool inStageOrder() {
+    for (size_t i = 1; i < STAGES.size(); ++i) {
+      if (STAGES[i] < STAGES[i - 1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  static_assert(inStageOrder(), "Pipeline systems must be in stage order.");
+
+public:
+  explicit Pipeline(Systems &...systems) : systems(systems...) {}
+
+  void run(Coordinator &ecs, Duration delta) {
+    std::apply(
+        [&ecs, delta](Systems &...system) {
+          (runSystem(system, ecs, delta), ...);
+        },
+        systems);
+  }
+
+private:
+  std::tuple<Systems &...> systems;
+};
+
+#endif // GAME_PIPELINE_HPP
@@ -0,0 +1,369 @@
+#include "prefab_data.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PREFAB_FILE_MMAP 1
+#endif
+
+namespace {
+constexpr std::array<char, 4> MAGIC = {'S', 'I', 'P', 'F'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint32_t n_prefabs;
+  uint32_t n_levels;
+};
+static_assert(std::is_trivially_copyable_v<PrefabRecord> &&
+              sizeof(PrefabRecord) % alignof(PrefabRecord) == 0);
+static_assert(sizeof(Header) % alignof(PrefabRecord) == 0 &&
+              sizeof(PrefabRecord) % alignof(LevelRecord) == 0);
+
+constexpr std::array<const char *, N_PREFAB_TEXTURES> TEXTURE_NAMES = {
+    "none",   "player", "alien1",       "alien2",
+    "alien3", "bullet", "enemy_bullet", "mothership",
+};
+
+template <class T> void append(std::vector<std::byte> &data, const T &value) {
+  const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+// One line of a prefab source file, split into words.
+class Line {
+public:
+  Line(const std::string &path, int number, const std::string &text)
+      : path(path), number(number), words(text) {}
+
+  template <class T> bool read(T &value) {
+    if constexpr (std::is_same_v<T, uint32_t>) {
+      // Allows layers to be written in hex.
+      std::string word;
+      if (not(words >> word)) {
+        return error("missing a value");
+      }
+      try {
+        value = static_cast<uint32_t>(std::stoul(word, nullptr, 0));
+      } catch (const std::exception &) {
+        return error("expected a number");
+      }
+      return true;
+    } else {
+      return static_cast<bool>(words >> value) || error("expected a number");
+    }
+  }
+  template <class... Ts> bool readAll(Ts &...values) {
+    return (read(values) && ...) && finished();
+  }
+  bool word(std::string &value) {
+    return static_cast<bool>(words >> value) || error("missing a word");
+  }
+  bool finished() {
+    std::string extra;
+    return not(words >> extra) || error("unexpected \"" + extra + "\"");
+  }
+  bool error(const std::string &message) const {
+    printf("%s:%d: %s\n", path.c_str(), number, message.c_str());
+    return false;
+  }
+
+private:
+  const std::string &path;
+  int number;
+  std::istringstream words;
+};
+
+bool readComponent(Line &line, const std::string &keyword,
+                   PrefabRecord &prefab) {
+  auto component = [&prefab](PrefabComponent flag) {
+    prefab.components |= flag;
+    return true;
+  };
+  if (keyword == "position") {
+    return line.readAll(prefab.x, prefab.y);
+  }
+  if (keyword == "player") {
+    return line.finished() && component(PREFAB_PLAYER);
+  }
+  if (keyword == "mothership") {
+    return line.finished() && component(PREFAB_MOTHERSHIP);
+  }
+  if (keyword == "alien") {
+    return line.finished() && component(PREFAB_ALIEN);
+  }
+  if (keyword == "animation") {
+    return line.readAll(prefab.source_x, prefab.source_y, prefab.source_w,
+                        prefab.source_h, prefab.steps, prefab.step_frames) &&
+           component(PREFAB_ANIMATION);
+  }
+  if (keyword == "sprite") {
+    std::string texture;
+    if (not line.word(texture)) {
+      return false;
+    }
+    const auto found = std::ranges::find(TEXTURE_NAMES, texture);
+    if (found == TEXTURE_NAMES.end()) {
+      return line.error("no texture called \"" + texture + "\"");
+    }
+    prefab.texture =
+        static_cast<PrefabTexture>(found - TEXTURE_NAMES.begin());
+    return line.readAll(prefab.width, prefab.height) &&
+           component(PREFAB_RENDER_COPY);
+  }
+  if (keyword == "velocity") {
+    return line.readAll(prefab.velocity_x, prefab.velocity_y) &&
+           component(PREFAB_VELOCITY);
+  }
+  if (keyword == "health") {
+    return line.readAll(prefab.health) && component(PREFAB_HEALTH);
+  }
+  if (keyword == "health_bar") {
+    return line.readAll(prefab.health_bar_hover) &&
+           component(PREFAB_HEALTH_BAR);
+  }
+  if (keyword == "bounds") {
+    return line.readAll(prefab.half_width, prefab.half_height,
+                        prefab.layers) &&
+           component(PREFAB_COLLISION_BOUNDS);
+  }
+  return line.error("unknown component \"" + keyword + "\"");
+}
+} // namespace
+
+std::optional<std::vector<std::byte>> compilePrefabs(const std::string &path) {
+  std::ifstream source(path);
+  if (not source) {
+    printf("Couldn't open %s\n", path.c_str());
+    return std::nullopt;
+  }
+
+  std::vector<PrefabRecord> prefabs;
+  std::vector<LevelRecord> levels;
+  std::optional<PrefabRecord> prefab;
+  std::string text;
+  for (int number = 1; std::getline(source, text); ++number) {
+    text = text.substr(0, text.find('#'));
+    Line line(path, number, text);
+    std::string keyword;
+    std::istringstream(text) >> keyword;
+    if (keyword.empty()) {
+      continue;
+    }
+    line.word(keyword);
+
+    if (prefab.has_value()) {
+      if (keyword == "end") {
+        if (not line.finished()) {
+          return std::nullopt;
+        }
+        prefabs.push_back(*prefab);
+        prefab.reset();
+      } else if (not readComponent(line, keyword, *prefab)) {
+        return std::nullopt;
+      }
+    } else if (keyword == "prefab") {
+      std::string name;
+      if (not line.word(name) || not line.finished()) {
+        return std::nullopt;
+      }
+      if (name.size() >= PrefabRecord{}.name.size()) {
+        line.error("the name \"" + name + "\" is too long");
+        return std::nullopt;
+      }
+      prefab.emplace();
+      std::ranges::copy(name, prefab->name.begin());
+    } else if (keyword == "level") {
+      LevelRecord level{};
+      if (not line.readAll(level.first_level, level.alien_rows,
+                           level.alien_columns, level.alien_speed,
+                           level.rows_per_level)) {
+        return std::nullopt;
+      }
+      if (not levels.empty() &&
+          level.first_level <= levels.back().first_level) {
+        line.error("levels must be in order");
+        return std::nullopt;
+      }
+      levels.push_back(level);
+    } else {
+      line.error("expected \"prefab\" or \"level\"");
+      return std::nullopt;
+    }
+  }
+  if (prefab.has_value()) {
+    printf("%s: the last prefab has no \"end\"\n", path.c_str());
+    return std::nullopt;
+  }
+  if (levels.empty() || levels.front().first_level != 1) {
+    printf("%s: there must be a level 1\n", path.c_str());
+    return std::nullopt;
+  }
+
+  std::vector<std::byte> data;
+  append(data, Header{MAGIC, VERSION, static_cast<uint32_t>(prefabs.size()),
+                      static_cast<uint32_t>(levels.size())});
+  for (const auto &record : prefabs) {
+    append(data, record);
+  }
+  for (const auto &record : levels) {
+    append(data, record);
+  }
+  return data;
+}
+
+std::optional<PrefabFile> PrefabFile::load(const std::string &path) {
+  namespace fs = std::filesystem;
+  const auto binary = fs::path(path).replace_extension(".bin").string();
+  std::error_code error;
+  const auto source_time = fs::last_write_time(path, error);
+  const bool has_source = not error;
+  const auto binary_time = fs::last_write_time(binary, error);
+  const bool stale = error || (has_source && binary_time < source_time);
+
+  if (not stale) {
+    if (auto file = open(binary)) {
+      return file;
+    }
+    if (not has_source) {
+      printf("%s isn't a compiled prefab file\n", binary.c_str());
+      return std::nullopt;
+    }
+    // From another version or build, or cut short while being written.
+    printf("%s can't be used, so it is compiled again\n", binary.c_str());
+  }
+
+  auto compiled = compilePrefabs(path);
+  if (not compiled.has_value()) {
+    return std::nullopt;
+  }
+  FILE *output = std::fopen(binary.c_str(), "wb");
+  const bool written =
+      output != nullptr &&
+      std::fwrite(compiled->data(), 1, compiled->size(), output) ==
+          compiled->size();
+  if (output == nullptr || std::fclose(output) != 0 || not written) {
+    // Still usable, just not cached for next time.
+    printf("Couldn't write %s\n", binary.c_str());
+    PrefabFile file;
+    file.owned = std::move(*compiled);
+    file.data = file.owned;
+    return file.parse() ? std::optional(std::move(file)) : std::nullopt;
+  }
+  return open(binary);
+}
+
+std::optional<PrefabFile> PrefabFile::open(const std::string &binary) {
+  PrefabFile file;
+#ifdef PREFAB_FILE_MMAP
+  const int descriptor = ::open(binary.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return std::nullopt;
+  }
+  struct stat status {};
+  if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+    const auto size = static_cast<size_t>(status.st_size);
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapped != MAP_FAILED) {
+      file.mapping = mapped;
+      file.data = {static_cast<const std::byte *>(mapped), size};
+    }
+  }
+  close(descriptor);
+  if (file.mapping == nullptr) {
+    return std::nullopt;
+  }
+#else
+  FILE *input = std::fopen(binary.c_str(), "rb");
+  if (input == nullptr) {
+    return std::nullopt;
+  }
+  std::array<std::byte, 4096> chunk{};
+  size_t n_read = 0;
+  while ((n_read = std::fread(chunk.data(), 1, chunk.size(), input)) > 0) {
+    file.owned.insert(file.owned.end(), chunk.begin(), chunk.begin() + n_read);
+  }
+  std::ignore = std::fclose(input);
+  file.data = file.owned;
+#endif
+  if (not file.parse()) {
+    return std::nullopt;
+  }
+  return file;
+}
+
+PrefabFile::~PrefabFile() {
+#ifdef PREFAB_FILE_MMAP
+  if (mapping != nullptr) {
+    munmap(mapping, data.size());
+  }
+#endif
+}
+
+PrefabFile::PrefabFile(PrefabFile &&other) noexcept
+    : data(std::exchange(other.data, {})),
+      mapping(std::exchange(other.mapping, nullptr)),
+      owned(std::move(other.owned)), prefabs(std::exchange(other.prefabs, {})),
+      levels(std::exchange(other.levels, {})) {
+  // Moving a vector keeps its buffer, so views of it stay valid.
+}
+
+bool PrefabFile::parse() {
+  Header header{};
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  const size_t size = sizeof(header) +
+                      header.n_prefabs * sizeof(PrefabRecord) +
+                      header.n_levels * sizeof(LevelRecord);
+  if (header.magic != MAGIC || header.version != VERSION ||
+      data.size() != size || header.n_levels == 0) {
+    return false;
+  }
+  // The records are used in place: the header keeps them aligned, and the
+  // data starts on a page, or wherever new put it.
+  const auto *records = data.data() + sizeof(header);
+  prefabs = {reinterpret_cast<const PrefabRecord *>(records),
+             header.n_prefabs};
+  levels = {reinterpret_cast<const LevelRecord *>(
+                records + header.n_prefabs * sizeof(PrefabRecord)),
+            header.n_levels};
+  // Records are trusted from here on, so anything that would index out of
+  // bounds is rejected now.
+  return std::ranges::all_of(prefabs, [](const PrefabRecord &record) {
+    return static_cast<uint32_t>(record.texture) < N_PREFAB_TEXTURES &&
+           std::ranges::find(record.name, '\0') != record.name.end();
+  });
+}
+
+const PrefabRecord *PrefabFile::prefab(std::string_view name) const {
+  const auto found = std::ranges::find_if(prefabs, [name](const auto &record) {
+    return std::string_view(record.name.data()) == name;
+  });
+  return found == prefabs.end() ? nullptr : &*found;
+}
+
+LevelRecord PrefabFile::level(int level) const {
+  // The last record starting at or before the level, or the first record.
+  auto record = levels.front();
+  for (const auto &later : levels) {
+    if (later.first_level <= level) {
+      record = later;
+    }
+  }
+  record.alien_rows += record.rows_per_level * (level - record.first_level);
+  record.first_level = level;
+  return record;
+}
@@ -0,0 +1,109 @@
+#ifndef GAME_PREFAB_DATA_HPP
+#define GAME_PREFAB_DATA_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Prefabs & levels are written as text (see data/prefabs.txt), and compiled
+// to a flat binary file next to it: a header, then fixed-size records that
+// are used in place, straight from the mapped file. Like snapshots, the
+// binary is only portable between builds for the same platform.
+
+// Textures a prefab can be drawn with.
+enum class PrefabTexture : uint32_t {
+  None,
+  Player,
+  Alien1,
+  Alien2,
+  Alien3,
+  Bullet,
+  EnemyBullet,
+  Mothership,
+};
+constexpr size_t N_PREFAB_TEXTURES = 8;
+
+// Which components a prefab has, besides the Position every prefab has.
+enum PrefabComponent : uint32_t {
+  PREFAB_ANIMATION = 1 << 0,
+  PREFAB_PLAYER = 1 << 1,
+  PREFAB_MOTHERSHIP = 1 << 2,
+  PREFAB_ALIEN = 1 << 3,
+  PREFAB_VELOCITY = 1 << 4,
+  PREFAB_RENDER_COPY = 1 << 5,
+  PREFAB_HEALTH = 1 << 6,
+  PREFAB_HEALTH_BAR = 1 << 7,
+  PREFAB_COLLISION_BOUNDS = 1 << 8,
+};
+
+// Every field is four bytes, so there is no padding.
+struct PrefabRecord {
+  std::array<char, 16> name;
+  uint32_t components;
+  float x, y;
+  // Animation: the first frame's source rectangle, and how long each of its
+  // steps lasts.
+  int32_t source_x, source_y, source_w, source_h;
+  int32_t steps, step_frames;
+  // RenderCopy.
+  PrefabTexture texture;
+  int32_t width, height;
+  float velocity_x, velocity_y;
+  float health;
+  float health_bar_hover;
+  // CollisionBounds.
+  float half_width, half_height;
+  uint32_t layers;
+};
+
+// The aliens of every level from first_level on, until the next record.
+struct LevelRecord {
+  int32_t first_level;
+  int32_t alien_rows;
+  int32_t alien_columns;
+  float alien_speed;
+  // Rows added for each level after the first.
+  int32_t rows_per_level;
+};
+
+// Parse a prefab source file. Errors are printed with their line number.
+std::optional<std::vector<std::byte>> compilePrefabs(const std::string &path);
+
+// A compiled prefab file, mapped into memory.
+class PrefabFile {
+public:
+  // Loads the binary compiled from the source at path, compiling it first if
+  // it is missing, older than the source, or can't be used.
+  static std::optional<PrefabFile> load(const std::string &path);
+
+  ~PrefabFile();
+  PrefabFile(PrefabFile &&other) noexcept;
+  PrefabFile &operator=(PrefabFile &&other) = delete;
+  PrefabFile(const PrefabFile &) = delete;
+  PrefabFile &operator=(const PrefabFile &) = delete;
+
+  [[nodiscard]] const PrefabRecord *prefab(std::string_view name) const;
+  // The aliens for a level, with rows added for levels past its record.
+  [[nodiscard]] LevelRecord level(int level) const;
+
+private:
+  // Either mapped, or held in memory if it couldn't be.
+  std::span<const std::byte> data;
+  void *mapping = nullptr;
+  std::vector<std::byte> owned;
+  std::span<const PrefabRecord> prefabs;
+  std::span<const LevelRecord> levels;
+
+  PrefabFile() = default;
+  // Map or read a compiled file, returning nothing if it isn't valid.
+  static std::optional<PrefabFile> open(const std::string &binary);
+  // Returns false if the data isn't a valid compiled file.
+  bool parse();
+};
+
+#endif // GAME_PREFAB_DATA_HPP
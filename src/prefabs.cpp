@@ -0,0 +1,124 @@
+#include "prefabs.hpp"
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace {
+// The record flag for each component. Every prefab has a Position.
+template <class C> constexpr uint32_t componentFlag() {
+  if constexpr (std::is_same_v<C, Animation>) {
+    return PREFAB_ANIMATION;
+  } else if constexpr (std::is_same_v<C, Player>) {
+    return PREFAB_PLAYER;
+  } else if constexpr (std::is_same_v<C, Mothership>) {
+    return PREFAB_MOTHERSHIP;
+  } else if constexpr (std::is_same_v<C, Alien>) {
+    return PREFAB_ALIEN;
+  } else if constexpr (std::is_same_v<C, Velocity>) {
+    return PREFAB_VELOCITY;
+  } else if constexpr (std::is_same_v<C, RenderCopy>) {
+    return PREFAB_RENDER_COPY;
+  } else if constexpr (std::is_same_v<C, Health>) {
+    return PREFAB_HEALTH;
+  } else if constexpr (std::is_same_v<C, HealthBar>) {
+    return PREFAB_HEALTH_BAR;
+  } else if constexpr (std::is_same_v<C, CollisionBounds>) {
+    return PREFAB_COLLISION_BOUNDS;
+  } else {
+    return 0;
+  }
+}
+} // namespace
+
+void makeStaticSprite(Entity entity, Coordinator &ecs, Position initPos,
+                      SDL_Texture *texture, int w, int h) {
+  ecs.addComponent<Position>(entity);
+  ecs.addComponent<RenderCopy>(entity);
+
+  ecs.getComponent<Position>(entity) = initPos;
+
+  auto &render_copy = ecs.getComponent<RenderCopy>(entity);
+  render_copy.texture = texture;
+  render_copy.w = w;
+  render_copy.h = h;
+}
+
+Prefab::Prefab(const PrefabRecord &record, const PrefabTextures &textures)
+    : components(record.components),
+      templates(
+          Animation{
+              {record.source_x, record.source_y, record.source_w,
+               record.source_h},
+              0,
+              record.steps,
+              record.step_frames * FRAME_DURATION,
+              {},
+          },
+          Player{}, Mothership{}, Alien{record.x},
+          Position{{record.x, record.y}},
+          Velocity{{record.velocity_x, record.velocity_y}},
+          RenderCopy{textures[static_cast<size_t>(record.texture)],
+                     record.width, record.height},
+          Health{record.health, record.health},
+          HealthBar{record.health_bar_hover},
+          CollisionBounds{{record.half_width, record.half_height},
+                          LayerMask{record.layers}}) {}
+
+void Prefab::spawn(Coordinator &ecs, EntityHandles &handles,
+                   std::span<const Position> positions,
+                   std::pmr::vector<Entity> &spawned) const {
+  const auto first = spawned.size();
+  for (size_t i = 0; i < positions.size(); ++i) {
+    spawned.push_back(handles.create());
+  }
+  const std::span<const Entity> entities(spawned.begin() + first,
+                                         spawned.end());
+  stamp(ecs, entities);
+
+  auto &stored_positions = ecs.getComponents<Position>();
+  for (size_t i = 0; i < entities.size(); ++i) {
+    stored_positions[entities[i]] = positions[i];
+  }
+}
+
+Entity Prefab::spawn(Coordinator &ecs, EntityHandles &handles,
+                     Position position) const {
+  const Entity entity = handles.create();
+  stamp(ecs, {&entity, 1});
+  ecs.getComponent<Position>(entity) = position;
+  return entity;
+}
+
+void Prefab::stamp(Coordinator &ecs, std::span<const Entity> entities) const {
+  std::apply(
+      [&](const auto &...values) {
+        (stampComponent(ecs, entities, values), ...);
+      },
+      templates);
+}
+
+template <class C>
+void Prefab::stampComponent(Coordinator &ecs, std::span<const Entity> entities,
+                            const C &value) const {
+  constexpr uint32_t FLAG = componentFlag<C>();
+  if ((components & FLAG) != FLAG) {
+    return;
+  }
+  for (const auto entity : entities) {
+    ecs.addComponent<C>(entity);
+  }
+  // Adding may have grown the storage, so it is only looked up afterwards.
+  auto &storage = ecs.getComponents<C>();
+  for (const auto entity : entities) {
+    storage[entity] = value;
+  }
+}
+
+Prefab findPrefab(const PrefabFile &file, std::string_view name,
+                  const PrefabTextures &textures) {
+  const auto *record = file.prefab(name);
+  if (record == nullptr) {
+    throw std::out_of_range("No prefab called " + std::string(name));
+  }
+  return {*record, textures};
+}
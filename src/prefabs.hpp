@@ -0,0 +1,75 @@
+#ifndef GAME_PREFABS_HPP
+#define GAME_PREFABS_HPP
+
+#include "collision_bounds.hpp"
+#include "components.hpp"
+#include "entity_handles.hpp"
+#include "prefab_data.hpp"
+#include <SDL2/SDL_render.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <tecs.hpp>
+#include <tuple>
+#include <vector>
+
+using namespace Tecs;
+using namespace std::literals::chrono_literals;
+
+// Framerate.
+constexpr Duration FRAME_DURATION = 1.0s / 60;
+
+// The title screen draws the player without a world.
+constexpr int32_t PLAYER_WIDTH = 96;
+constexpr int32_t PLAYER_HEIGHT = 48;
+
+void makeStaticSprite(Entity entity, Coordinator &ecs, Position initPos,
+                      SDL_Texture *texture, int w, int h);
+
+// Indexed by PrefabTexture. Headless worlds leave them null.
+using PrefabTextures = std::array<SDL_Texture *, N_PREFAB_TEXTURES>;
+
+// An entity's components, built once from its record. Spawning copies each of
+// them into storage for every new entity before moving on to the next, so a
+// whole wave of aliens is stamped out in one pass per component.
+class Prefab {
+public:
+  Prefab(const PrefabRecord &record, const PrefabTextures &textures);
+
+  // Create an entity at each position, appending them to spawned in order.
+  void spawn(Coordinator &ecs, EntityHandles &handles,
+             std::span<const Position> positions,
+             std::pmr::vector<Entity> &spawned) const;
+  Entity spawn(Coordinator &ecs, EntityHandles &handles,
+               Position position) const;
+  // At the position in its record.
+  Entity spawn(Coordinator &ecs, EntityHandles &handles) const {
+    return spawn(ecs, handles, std::get<Position>(templates));
+  }
+
+  template <class C> [[nodiscard]] const C &component() const {
+    return std::get<C>(templates);
+  }
+
+private:
+  uint32_t components;
+  // Animation goes first, so it is added before anything that would put an
+  // entity in StaticSpriteRenderingSystem, which excludes it.
+  std::tuple<Animation, Player, Mothership, Alien, Position, Velocity,
+             RenderCopy, Health, HealthBar, CollisionBounds>
+      templates;
+
+  void stamp(Coordinator &ecs, std::span<const Entity> entities) const;
+  template <class C>
+  void stampComponent(Coordinator &ecs, std::span<const Entity> entities,
+                      const C &value) const;
+};
+
+// Throws std::out_of_range if the file has no prefab called name.
+Prefab findPrefab(const PrefabFile &file, std::string_view name,
+                  const PrefabTextures &textures);
+
+#endif // GAME_PREFABS_HPP
@@ -23,4 +23,8 @@ inline bool pointInRectangle(const Rectangle &a, const Position &pos) {
   const auto &p = pos.p;
   return (a.x < p.x && p.x < a.x + a.w && a.y < p.y && p.y < a.y + a.h);
 }
+// Return the input rectangle, with its centre where its top left corner was.
+constexpr SDL_Rect centered_rectangle(SDL_Rect rect) {
+  return {rect.x - rect.w / 2, rect.y - rect.h / 2, rect.w, rect.h};
+}
 #endif // GAME_RECTANGLE_HPP
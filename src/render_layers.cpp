@@ -0,0 +1,136 @@
+#include "render_layers.hpp"
+#include "rectangle.hpp"
+#include "sdl.hpp"
+
+void drawHealthBar(DrawList &draw_list, const glm::vec2 &pos,
+                   const Health &health, const HealthBar &bar) {
+  constexpr int BAR_HEIGHT = 5;
+  constexpr int BAR_LENGTH = 30;
+  SDL_Rect current_bar;
+  SDL_Rect empty_bar;
+  empty_bar.h = current_bar.h = BAR_HEIGHT;
+  empty_bar.y = current_bar.y =
+      static_cast<int>(pos.y + bar.hover_distance - BAR_HEIGHT);
+  current_bar.x = static_cast<int>(pos.x - (float)BAR_LENGTH / 2);
+  current_bar.w = static_cast<int>((health.current / health.max) * BAR_LENGTH);
+  empty_bar.x = current_bar.x + current_bar.w;
+  empty_bar.w = BAR_LENGTH - current_bar.w;
+  // Opaque, since the bar may be drawn into a transparent layer.
+  // Remaining health.
+  draw_list.fill(current_bar, {0xFF, 0xFF, 0x00, 0xFF});
+  // Leftover health bar.
+  draw_list.fill(empty_bar, {0xFF, 0x00, 0x00, 0xFF});
+}
+
+LayerCache::LayerCache(SDL_Renderer *renderer, const SDL_Rect &dimensions)
+    : renderer(renderer), dimensions(dimensions) {
+  for (auto &target : targets) {
+    target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                               SDL_TEXTUREACCESS_TARGET, dimensions.w,
+                               dimensions.h);
+    if (target == nullptr) {
+      throw SDL::Error(__FILE__, __LINE__);
+    }
+    SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);
+    // Layers are only drawn once they are first recorded, so must not hold
+    // garbage until then.
+    SDL_SetRenderTarget(renderer, target);
+    SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+    SDL_RenderClear(renderer);
+  }
+  SDL_SetRenderTarget(renderer, nullptr);
+}
+
+LayerCache::~LayerCache() {
+  for (auto *target : targets) {
+    SDL_DestroyTexture(target);
+  }
+}
+
+void LayerCache::update(const FrameCommands &frame) {
+  for (const auto &update : frame.mask_updates) {
+    update.submit();
+  }
+
+  bool redrawn = false;
+  for (size_t layer = 0; layer < N_LAYERS; ++layer) {
+    if (not frame.layer_dirty[layer]) {
+      continue;
+    }
+    SDL_SetRenderTarget(renderer, targets[layer]);
+    SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+    SDL_RenderClear(renderer);
+    frame.layers[layer].submit(renderer);
+    redrawn = true;
+  }
+  if (redrawn) {
+    SDL_SetRenderTarget(renderer, nullptr);
+  }
+}
+
+void LayerCache::draw(Layer layer) const {
+  // An explicit destination, so the layer follows any render scale.
+  const SDL_Rect destination = {0, 0, dimensions.w, dimensions.h};
+  SDL_RenderCopy(renderer, targets[static_cast<size_t>(layer)], nullptr,
+                 &destination);
+}
+
+void LayerRenderingSystem::run(const std::set<Entity> &entities,
+                               Coordinator &ecs, const Duration delta) {
+  std::ignore = delta;
+  auto [layereds, positions, render_copies] =
+      componentStorage<Layered, Position, RenderCopy>(ecs);
+
+  // Invalidate layers whose entities were damaged or destroyed.
+  std::array<size_t, N_LAYERS> counts{};
+  for (const auto &e : entities) {
+    const auto &layered = layereds[e];
+    counts[static_cast<size_t>(layered.layer)]++;
+    if (ecs.hasComponent<Health>(e) &&
+        ecs.getComponent<Health>(e).current != layered.drawn_health) {
+      invalidate(layered.layer);
+    }
+  }
+  for (size_t layer = 0; layer < N_LAYERS; ++layer) {
+    if (counts[layer] != drawn_counts[layer]) {
+      dirty[layer] = true;
+    }
+  }
+  drawn_counts = counts;
+
+  auto &frame = buffers.back();
+  for (size_t layer = 0; layer < N_LAYERS; ++layer) {
+    if (not dirty[layer]) {
+      continue;
+    }
+    auto &draw_list = frame.layers[layer];
+    draw_list.clear();
+
+    if (static_cast<Layer>(layer) == Layer::Background) {
+      draw_list.fill({0, border, width, 1}, {0xFF, 0x00, 0x00, 0xFF});
+    }
+
+    for (const auto &e : entities) {
+      auto &layered = layereds[e];
+      if (static_cast<size_t>(layered.layer) != layer) {
+        continue;
+      }
+      const auto &[pos] = positions[e];
+      const auto &render_copy = render_copies[e];
+      draw_list.sprite(render_copy.texture,
+                       centered_rectangle({(int)pos.x, (int)pos.y,
+                                           render_copy.w, render_copy.h}));
+
+      if (ecs.hasComponent<Health>(e)) {
+        const auto &health = ecs.getComponent<Health>(e);
+        if (ecs.hasComponent<HealthBar>(e)) {
+          drawHealthBar(draw_list, pos, health,
+                        ecs.getComponent<HealthBar>(e));
+        }
+        layered.drawn_health = health.current;
+      }
+    }
+    frame.layer_dirty[layer] = true;
+    dirty[layer] = false;
+  }
+}
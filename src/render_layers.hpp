@@ -0,0 +1,69 @@
+#ifndef GAME_RENDER_LAYERS_HPP
+#define GAME_RENDER_LAYERS_HPP
+
+#include "components.hpp"
+#include "draw_commands.hpp"
+#include "pipeline.hpp"
+#include <SDL2/SDL_render.h>
+#include <array>
+#include <cstddef>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// Marks an entity as belonging to a cached layer. Must be added before the
+// components that would otherwise put it in the per-frame sprite & health bar
+// systems.
+struct Layered {
+  Layer layer;
+  // The health the entity had when its layer was last drawn.
+  float drawn_health = -1;
+};
+
+void drawHealthBar(DrawList &draw_list, const glm::vec2 &pos,
+                   const Health &health, const HealthBar &bar);
+
+// The textures holding each layer. Owned by the rendering thread.
+struct LayerCache {
+  SDL_Renderer *renderer;
+  SDL_Rect dimensions;
+  std::array<SDL_Texture *, N_LAYERS> targets{};
+
+  LayerCache(SDL_Renderer *renderer, const SDL_Rect &dimensions);
+  ~LayerCache();
+  LayerCache(const LayerCache &) = delete;
+  LayerCache &operator=(const LayerCache &) = delete;
+
+  // Update damaged textures, then redraw the layers that changed in this
+  // frame.
+  void update(const FrameCommands &frame);
+  // Copy the cached layer onto the current render target.
+  void draw(Layer layer) const;
+};
+
+// Records new contents for the layers whose entities have changed.
+struct LayerRenderingSystem final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = ComponentList<Layered, Position, RenderCopy>;
+  using Excluded = ComponentList<>;
+
+  DrawCommandBuffers &buffers;
+  int border;
+  int width;
+  std::array<bool, N_LAYERS> dirty{};
+  std::array<size_t, N_LAYERS> drawn_counts{};
+
+  LayerRenderingSystem(Coordinator &coord, DrawCommandBuffers &buffers,
+                       int border, int width)
+      : System(signatureOf<LayerRenderingSystem>(coord), coord),
+        buffers(buffers), border(border), width(width) {
+    dirty.fill(true);
+  }
+
+  void invalidate(Layer layer) { dirty[static_cast<size_t>(layer)] = true; }
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override;
+};
+
+#endif // GAME_RENDER_LAYERS_HPP
@@ -0,0 +1,264 @@
+#include "replay.hpp"
+#include <array>
+#include <cstring>
+#include <tuple>
+
+namespace {
+constexpr std::array<char, 4> MAGIC = {'S', 'I', 'R', 'P'};
+constexpr uint32_t VERSION = 2;
+
+// Each record starts with a tag byte. Runs of input use the packed input
+// itself as their tag, followed by the length of the run.
+constexpr uint8_t INPUT_BITS = 0x07;
+constexpr uint8_t LEVEL = 0x80;
+constexpr uint8_t KEYFRAME = 0x81;
+} // namespace
+
+uint8_t packInput(const Input &input) {
+  return static_cast<uint8_t>((input.left ? 0x1 : 0) | (input.right ? 0x2 : 0) |
+                              (input.fire ? 0x4 : 0));
+}
+
+Input unpackInput(uint8_t bits) {
+  return {(bits & 0x1) != 0, (bits & 0x2) != 0, (bits & 0x4) != 0};
+}
+
+ReplayWriter::ReplayWriter(const std::string &path, uint64_t seed)
+    : file(std::fopen(path.c_str(), "wb")) {
+  if (file == nullptr) {
+    return;
+  }
+  write(MAGIC.data(), MAGIC.size());
+  write(&VERSION, sizeof(VERSION));
+  write(&seed, sizeof(seed));
+}
+
+ReplayWriter::~ReplayWriter() {
+  if (file != nullptr) {
+    endRun();
+    std::ignore = std::fclose(file);
+  }
+}
+
+void ReplayWriter::beginLevel(LevelStart start) {
+  endRun();
+  write(&LEVEL, sizeof(LEVEL));
+  write(&start.level, sizeof(start.level));
+  write(&start.score, sizeof(start.score));
+  // Keep what has been recorded so far if the game crashes.
+  std::ignore = std::fflush(file);
+}
+
+void ReplayWriter::frame(const Input &input) {
+  const uint8_t bits = packInput(input);
+  if (run_length > 0 && bits != run_input) {
+    endRun();
+  }
+  run_input = bits;
+  run_length++;
+}
+
+void ReplayWriter::keyframe(uint64_t frame, std::span<const std::byte> snapshot,
+                            uint64_t state_hash) {
+  endRun();
+  write(&KEYFRAME, sizeof(KEYFRAME));
+  writeVarint(frame);
+  writeVarint(snapshot.size());
+  write(snapshot.data(), snapshot.size());
+  write(&state_hash, sizeof(state_hash));
+}
+
+void ReplayWriter::endRun() {
+  if (run_length == 0) {
+    return;
+  }
+  write(&run_input, sizeof(run_input));
+  writeVarint(run_length);
+  run_length = 0;
+}
+
+void ReplayWriter::write(const void *data, size_t size) {
+  if (file != nullptr) {
+    std::ignore = std::fwrite(data, 1, size, file);
+  }
+}
+
+// LEB128: 7 bits at a time, with the top bit set on all but the last byte.
+void ReplayWriter::writeVarint(uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value != 0) {
+      byte |= 0x80;
+    }
+    write(&byte, sizeof(byte));
+  } while (value != 0);
+}
+
+std::optional<ReplayReader> ReplayReader::open(const std::string &path) {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return std::nullopt;
+  }
+  ReplayReader reader;
+  std::array<std::byte, 64 * 1024> chunk{};
+  size_t n_read = 0;
+  while ((n_read = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+    reader.data.insert(reader.data.end(), chunk.begin(),
+                       chunk.begin() + n_read);
+  }
+  std::ignore = std::fclose(file);
+
+  std::array<char, 4> magic{};
+  uint32_t version = 0;
+  if (reader.data.size() <
+      magic.size() + sizeof(version) + sizeof(reader.session_seed)) {
+    return std::nullopt;
+  }
+  reader.read(magic.data(), magic.size());
+  reader.read(&version, sizeof(version));
+  if (magic != MAGIC || version != VERSION) {
+    return std::nullopt;
+  }
+  reader.read(&reader.session_seed, sizeof(reader.session_seed));
+  reader.records = reader.offset;
+  return reader;
+}
+
+std::optional<LevelStart> ReplayReader::nextLevel() {
+  // Frames left in the level mean the game finished it sooner than it did
+  // when it was recorded.
+  uint64_t unplayed = run_remaining;
+  run_remaining = 0;
+  while (not atEnd() && peekTag() != LEVEL) {
+    if (peekTag() == KEYFRAME) {
+      readKeyframe();
+    } else {
+      offset++;
+      unplayed += readVarint();
+    }
+  }
+  if (unplayed > 0) {
+    printf("Replay diverged: %llu recorded frames of the level weren't "
+           "played\n",
+           static_cast<unsigned long long>(unplayed));
+  }
+  if (atEnd()) {
+    return std::nullopt;
+  }
+
+  offset++;
+  LevelStart start{};
+  read(&start.level, sizeof(start.level));
+  read(&start.score, sizeof(start.score));
+  if (truncated) {
+    return std::nullopt;
+  }
+  return start;
+}
+
+std::optional<Input> ReplayReader::nextFrame() {
+  while (run_remaining == 0) {
+    if (atEnd() || peekTag() == LEVEL) {
+      return std::nullopt;
+    }
+    if (peekTag() == KEYFRAME) {
+      const auto keyframe = readKeyframe();
+      if (not truncated) {
+        checkpoint = Checkpoint{keyframe.frame, keyframe.state_hash};
+      }
+      continue;
+    }
+    run_input = peekTag() & INPUT_BITS;
+    offset++;
+    run_remaining = readVarint();
+  }
+  run_remaining--;
+  return unpackInput(run_input);
+}
+
+std::optional<SeekPoint> ReplayReader::seek(uint64_t frame) {
+  offset = records;
+  run_remaining = 0;
+  truncated = false;
+  // Frames in the levels before the current one.
+  uint64_t level_begin = 0;
+  while (auto start = nextLevel()) {
+    SeekPoint point{*start, {}, 0, 0};
+    size_t resume = offset;
+    uint64_t frames = 0;
+    while (not atEnd() && peekTag() != LEVEL) {
+      if (peekTag() == KEYFRAME) {
+        const auto keyframe = readKeyframe();
+        if (not truncated && level_begin + keyframe.frame <= frame) {
+          point.snapshot = keyframe.snapshot;
+          point.keyframe = keyframe.frame;
+          resume = offset;
+        }
+      } else {
+        offset++;
+        frames += readVarint();
+      }
+    }
+
+    if (frame < level_begin + frames) {
+      // Only the frames before any truncation were counted, so those from
+      // the resume point on can be read again.
+      offset = resume;
+      truncated = false;
+      point.frame = frame - level_begin;
+      return point;
+    }
+    level_begin += frames;
+  }
+  return std::nullopt;
+}
+
+void ReplayReader::read(void *destination, size_t size) {
+  if (truncated || size > data.size() - offset) {
+    truncated = true;
+    offset = data.size();
+    return;
+  }
+  std::memcpy(destination, data.data() + offset, size);
+  offset += size;
+}
+
+uint64_t ReplayReader::readVarint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte = 0;
+    read(&byte, sizeof(byte));
+    if (truncated) {
+      return 0;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  // Too long to fit in 64 bits.
+  truncated = true;
+  offset = data.size();
+  return 0;
+}
+
+ReplayReader::Keyframe ReplayReader::readKeyframe() {
+  offset++;
+  Keyframe keyframe{};
+  keyframe.frame = readVarint();
+  const uint64_t size = readVarint();
+  if (truncated || size > data.size() - offset) {
+    truncated = true;
+    offset = data.size();
+    return keyframe;
+  }
+  keyframe.snapshot = {data.data() + offset, size};
+  offset += size;
+  read(&keyframe.state_hash, sizeof(keyframe.state_hash));
+  return keyframe;
+}
+
+std::optional<Checkpoint> ReplayReader::takeCheckpoint() {
+  return std::exchange(checkpoint, std::nullopt);
+}
@@ -0,0 +1,127 @@
+#ifndef GAME_REPLAY_HPP
+#define GAME_REPLAY_HPP
+
+#include "input.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A replay is the session's RNG seed, then for each level played: the level
+// & score it started with, and the input of every frame. Inputs are stored
+// as runs of identical frames, which is typically a few bytes per second of
+// play. Snapshots of the world are added every so often as keyframes, so a
+// replay can be started part of the way through without simulating
+// everything before it. Keyframes also hold the world's state hash, so a
+// replay can check it is still playing out as recorded.
+
+// How often the recording saves a keyframe.
+constexpr uint64_t KEYFRAME_INTERVAL = 600;
+
+struct LevelStart {
+  int32_t level;
+  uint32_t score;
+};
+
+// The state hash of the world after the given number of frames of the level.
+struct Checkpoint {
+  uint64_t frame;
+  uint64_t state_hash;
+};
+
+class ReplayWriter {
+public:
+  ReplayWriter(const std::string &path, uint64_t seed);
+  ~ReplayWriter();
+  ReplayWriter(const ReplayWriter &) = delete;
+  ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+  [[nodiscard]] bool good() const { return file != nullptr; }
+
+  void beginLevel(LevelStart start);
+  void frame(const Input &input);
+  // A snapshot taken after the given number of frames of the level.
+  void keyframe(uint64_t frame, std::span<const std::byte> snapshot,
+                uint64_t state_hash);
+
+private:
+  FILE *file;
+  uint8_t run_input = 0;
+  uint64_t run_length = 0;
+
+  void endRun();
+  void write(const void *data, size_t size);
+  void writeVarint(uint64_t value);
+};
+
+// Where to start playing a replay from.
+struct SeekPoint {
+  LevelStart start;
+  // The keyframe to restore, which is empty to start from the beginning of
+  // the level, and how many frames of the level it was taken after.
+  std::span<const std::byte> snapshot;
+  uint64_t keyframe;
+  // The frame of the level that was asked for.
+  uint64_t frame;
+};
+
+class ReplayReader {
+public:
+  static std::optional<ReplayReader> open(const std::string &path);
+
+  [[nodiscard]] uint64_t seed() const { return session_seed; }
+  // False once a record was found cut short, as a replay is when the game
+  // crashes while recording. Everything before it still plays.
+  [[nodiscard]] bool good() const { return not truncated; }
+
+  // Move on to the next level, or return nothing at the end of the replay.
+  std::optional<LevelStart> nextLevel();
+  // The next frame's input, or nothing once the level's frames run out.
+  std::optional<Input> nextFrame();
+  // Find the level containing the given frame of the whole replay, and the
+  // last keyframe before it. The next frame read is the one after the
+  // keyframe.
+  std::optional<SeekPoint> seek(uint64_t frame);
+  // The checkpoint of the last keyframe nextFrame() passed, if it hasn't
+  // been taken already.
+  std::optional<Checkpoint> takeCheckpoint();
+
+private:
+  struct Keyframe {
+    uint64_t frame;
+    std::span<const std::byte> snapshot;
+    uint64_t state_hash;
+  };
+
+  std::vector<std::byte> data;
+  size_t offset = 0;
+  size_t records = 0; // Where the records start.
+  uint64_t session_seed = 0;
+  uint8_t run_input = 0;
+  uint64_t run_remaining = 0;
+  std::optional<Checkpoint> checkpoint;
+  bool truncated = false;
+
+  ReplayReader() = default;
+
+  [[nodiscard]] bool atEnd() const { return offset >= data.size(); }
+  [[nodiscard]] uint8_t peekTag() const {
+    return static_cast<uint8_t>(data[offset]);
+  }
+  // Reading past the end, or a malformed varint, marks the replay truncated
+  // and moves to the end, leaving the destination as it was.
+  void read(void *destination, size_t size);
+  uint64_t readVarint();
+  // Skip a keyframe record, returning what it holds.
+  Keyframe readKeyframe();
+};
+
+// The input packed into the low bits of a byte.
+uint8_t packInput(const Input &input);
+Input unpackInput(uint8_t bits);
+
+#endif // GAME_REPLAY_HPP
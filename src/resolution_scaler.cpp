@@ -0,0 +1,72 @@
+#include "resolution_scaler.hpp"
+#include "sdl.hpp"
+#include <algorithm>
+#include <cstdio>
+
+constexpr float MIN_SCALE = 0.5;
+constexpr float SCALE_STEP = 0.125;
+// Weight of the newest frame in the moving average of frame times.
+constexpr double SMOOTHING = 0.1;
+// Fractions of the frame budget which trigger a change in scale.
+constexpr double DOWNSCALE_LOAD = 0.9;
+constexpr double UPSCALE_LOAD = 0.6;
+// Frames to wait after changing scale, for the average to catch up.
+constexpr int SETTLE_FRAMES = 30;
+
+ResolutionScaler::ResolutionScaler(SDL_Renderer *renderer,
+                                   const SDL_Rect &dimensions, Duration budget)
+    : renderer(renderer), width(dimensions.w), height(dimensions.h),
+      target(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                               SDL_TEXTUREACCESS_TARGET, dimensions.w,
+                               dimensions.h)),
+      budget(budget) {
+  if (target == nullptr) {
+    throw SDL::Error(__FILE__, __LINE__);
+  }
+  // Smooth out the blockiness of stretching a low resolution frame.
+  SDL_SetTextureScaleMode(target, SDL_ScaleModeLinear);
+}
+
+ResolutionScaler::~ResolutionScaler() { SDL_DestroyTexture(target); }
+
+void ResolutionScaler::beginFrame() {
+  // At full scale, draw straight to the window and skip the extra copy.
+  if (not scaled()) {
+    return;
+  }
+  // Setting a render target resets the scale, so it must be set afterwards.
+  SDL_SetRenderTarget(renderer, target);
+  SDL_RenderSetScale(renderer, current_scale, current_scale);
+}
+
+void ResolutionScaler::endFrame() {
+  if (not scaled()) {
+    return;
+  }
+  SDL_SetRenderTarget(renderer, nullptr);
+  const SDL_Rect scaled_frame = {
+      0, 0, static_cast<int>((float)width * current_scale),
+      static_cast<int>((float)height * current_scale)};
+  SDL_RenderCopy(renderer, target, &scaled_frame, nullptr);
+}
+
+void ResolutionScaler::recordFrameTime(Duration work) {
+  average_work = SMOOTHING * work + (1 - SMOOTHING) * average_work;
+
+  frames_since_change++;
+  if (frames_since_change < SETTLE_FRAMES) {
+    return;
+  }
+
+  const float previous_scale = current_scale;
+  if (average_work > DOWNSCALE_LOAD * budget) {
+    current_scale = std::max(MIN_SCALE, current_scale - SCALE_STEP);
+  } else if (average_work < UPSCALE_LOAD * budget) {
+    current_scale = std::min(1.0F, current_scale + SCALE_STEP);
+  }
+
+  if (current_scale != previous_scale) {
+    frames_since_change = 0;
+    printf("Resolution scale: %.3f\n", current_scale);
+  }
+}
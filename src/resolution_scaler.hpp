@@ -0,0 +1,44 @@
+#ifndef GAME_RESOLUTION_SCALER_HPP
+#define GAME_RESOLUTION_SCALER_HPP
+
+#include <SDL2/SDL_render.h>
+#include <tecs.hpp>
+
+using namespace Tecs;
+
+// Renders frames into an offscreen target at a fraction of the window's
+// resolution, then stretches them over the window. The fraction is lowered
+// while frames take longer than the frame budget, and raised again once there
+// is time to spare, so slow machines lose detail instead of frames.
+// Drawing coordinates are unaffected by the scale.
+class ResolutionScaler {
+public:
+  ResolutionScaler(SDL_Renderer *renderer, const SDL_Rect &dimensions,
+                   Duration budget);
+  ~ResolutionScaler();
+  ResolutionScaler(const ResolutionScaler &) = delete;
+  ResolutionScaler &operator=(const ResolutionScaler &) = delete;
+
+  // Redirect rendering to the scaled target.
+  void beginFrame();
+  // Copy the scaled target onto the window.
+  void endFrame();
+  // Adjust the scale given the time it took to simulate & draw a frame.
+  void recordFrameTime(Duration work);
+
+  [[nodiscard]] float scale() const { return current_scale; }
+
+private:
+  SDL_Renderer *renderer;
+  int width;
+  int height;
+  SDL_Texture *target;
+  Duration budget;
+  float current_scale = 1.0;
+  Duration average_work{};
+  int frames_since_change = 0;
+
+  [[nodiscard]] bool scaled() const { return current_scale < 1.0F; }
+};
+
+#endif // GAME_RESOLUTION_SCALER_HPP
@@ -0,0 +1,336 @@
+#include "snapshot.hpp"
+#include "collision_bounds.hpp"
+#include "components.hpp"
+#include "destructible.hpp"
+#include "pipeline.hpp"
+#include "render_layers.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <tuple>
+
+namespace {
+constexpr std::array<char, 4> MAGIC = {'S', 'I', 'S', 'S'};
+constexpr uint32_t VERSION = 7;
+
+struct Header {
+  std::array<char, 4> magic;
+  uint32_t version;
+  int32_t level;
+  uint32_t n_components;
+  uint64_t size;
+};
+
+// Every component a snapshot holds. On restore they are added in this order,
+// so the components systems exclude must come before the ones they require.
+using SnapshotComponents =
+    ComponentList<Layered, Animation, Player, Mothership, Alien, Position,
+                  Velocity, RenderCopy, Health, HealthBar, CollisionBounds,
+                  LifeTime, Destructible>;
+// Which components an entity has, one bit per component in the list above.
+using ComponentMask = uint16_t;
+
+template <class... Components>
+constexpr uint32_t componentCount(ComponentList<Components...> /*unused*/) {
+  return sizeof...(Components);
+}
+constexpr uint32_t N_COMPONENTS = componentCount(SnapshotComponents{});
+static_assert(N_COMPONENTS <= sizeof(ComponentMask) * 8);
+
+// Components are stored as themselves, except for texture pointers, which
+// are replaced by asset IDs.
+struct StoredRenderCopy {
+  uint32_t texture;
+  int w;
+  int h;
+};
+
+template <class C> C toStored(const C &component, const TextureAssets &) {
+  return component;
+}
+StoredRenderCopy toStored(const RenderCopy &render_copy,
+                          const TextureAssets &assets) {
+  return {assets.id(render_copy.texture), render_copy.w, render_copy.h};
+}
+template <class C> C fromStored(const C &component, const TextureAssets &) {
+  return component;
+}
+RenderCopy fromStored(const StoredRenderCopy &render_copy,
+                      const TextureAssets &assets) {
+  return {assets.texture(render_copy.texture), render_copy.w, render_copy.h};
+}
+
+// Whether a stored value can be restored without anything reading out of
+// bounds later.
+template <class C>
+bool validStored(const C & /*unused*/, const TextureAssets & /*unused*/) {
+  return true;
+}
+bool validStored(const Layered &layered, const TextureAssets & /*unused*/) {
+  return static_cast<size_t>(layered.layer) < N_LAYERS;
+}
+bool validStored(const StoredRenderCopy &render_copy,
+                 const TextureAssets &assets) {
+  return assets.known(render_copy.texture);
+}
+bool validStored(const Destructible &destructible,
+                 const TextureAssets & /*unused*/) {
+  const auto &dirty = destructible.dirty;
+  return destructible.width >= 0 && destructible.width <= MASK_MAX_WIDTH &&
+         destructible.height >= 0 && destructible.height <= MASK_MAX_HEIGHT &&
+         destructible.scale >= 1 && dirty.x >= 0 && dirty.y >= 0 &&
+         dirty.w >= 0 && dirty.h >= 0 &&
+         dirty.x + dirty.w <= destructible.width &&
+         dirty.y + dirty.h <= destructible.height;
+}
+
+template <class C> struct Stored {
+  using Type = C;
+};
+template <> struct Stored<RenderCopy> {
+  using Type = StoredRenderCopy;
+};
+
+template <class... Components>
+void saveComponents(ComponentList<Components...> /*unused*/,
+                    SnapshotWriter &writer, Coordinator &ecs,
+                    std::span<const Entity> entities,
+                    const TextureAssets &assets) {
+  for (const auto entity : entities) {
+    ComponentMask mask = 0;
+    ComponentMask bit = 1;
+    ((mask |= ecs.hasComponent<Components>(entity) ? bit : 0, bit <<= 1), ...);
+    writer.value(mask);
+  }
+
+  // Each component's values are packed together.
+  auto save = [&]<class C>() {
+    if constexpr (not std::is_empty_v<C>) {
+      const auto &storage = ecs.getComponents<C>();
+      for (const auto entity : entities) {
+        if (ecs.hasComponent<C>(entity)) {
+          writer.value(toStored(storage[entity], assets));
+        }
+      }
+    }
+  };
+  (save.template operator()<Components>(), ...);
+}
+
+template <class... Components>
+bool validateComponents(ComponentList<Components...> /*unused*/,
+                        SnapshotReader &reader, size_t n_entities,
+                        const TextureAssets &assets) {
+  if (reader.remaining() / sizeof(ComponentMask) < n_entities) {
+    return false;
+  }
+  std::vector<ComponentMask> masks(n_entities);
+  reader.values(std::span(masks));
+  constexpr ComponentMask ALL = (1U << N_COMPONENTS) - 1;
+  if (std::ranges::any_of(masks,
+                          [](auto mask) { return (mask & ~ALL) != 0; })) {
+    return false;
+  }
+
+  bool valid = true;
+  ComponentMask bit = 1;
+  auto validate = [&]<class C>() {
+    if constexpr (not std::is_empty_v<C>) {
+      for (const auto mask : masks) {
+        if ((mask & bit) == 0) {
+          continue;
+        }
+        typename Stored<C>::Type stored{};
+        reader.value(stored);
+        valid = valid && reader.good() && validStored(stored, assets);
+      }
+    }
+    bit <<= 1;
+  };
+  (validate.template operator()<Components>(), ...);
+  return valid;
+}
+
+template <class... Components>
+void restoreComponents(ComponentList<Components...> /*unused*/,
+                       SnapshotReader &reader, Coordinator &ecs,
+                       std::span<const Entity> entities,
+                       const TextureAssets &assets) {
+  std::vector<ComponentMask> masks(entities.size());
+  reader.values(std::span(masks));
+
+  ComponentMask bit = 1;
+  auto restore = [&]<class C>() {
+    for (size_t i = 0; i < entities.size(); ++i) {
+      if ((masks[i] & bit) == 0) {
+        continue;
+      }
+      ecs.addComponent<C>(entities[i]);
+      if constexpr (not std::is_empty_v<C>) {
+        typename Stored<C>::Type stored;
+        reader.value(stored);
+        ecs.getComponent<C>(entities[i]) = fromStored(stored, assets);
+      }
+    }
+    bit <<= 1;
+  };
+  (restore.template operator()<Components>(), ...);
+}
+} // namespace
+
+SnapshotWriter::SnapshotWriter(std::vector<std::byte> &data, int32_t level)
+    : data(data) {
+  data.clear();
+  value(Header{MAGIC, VERSION, level, N_COMPONENTS, 0});
+}
+
+void SnapshotWriter::finish() {
+  const uint64_t size = data.size();
+  std::memcpy(data.data() + offsetof(Header, size), &size, sizeof(size));
+}
+
+std::optional<SnapshotReader>
+SnapshotReader::open(std::span<const std::byte> data) {
+  Header header;
+  if (data.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION ||
+      header.n_components != N_COMPONENTS || header.size != data.size()) {
+    return std::nullopt;
+  }
+
+  SnapshotReader reader(data);
+  reader.offset = sizeof(header);
+  reader.snapshot_level = header.level;
+  return reader;
+}
+
+void saveEntities(SnapshotWriter &writer, Coordinator &ecs,
+                  const EntityHandles &handles, const TextureAssets &assets) {
+  const auto n_slots = static_cast<uint32_t>(handles.capacity());
+  writer.value(n_slots);
+  for (uint32_t slot = 0; slot < n_slots; ++slot) {
+    writer.value(handles.slotGeneration(slot));
+  }
+  const auto free_slots = handles.freeSlots();
+  writer.value(static_cast<uint32_t>(free_slots.size()));
+  writer.values(free_slots);
+
+  // Live slots, in the order their entities were created, so they can be
+  // recreated in the same order.
+  std::vector<uint32_t> live;
+  for (uint32_t slot = 0; slot < n_slots; ++slot) {
+    if (handles.slotEntity(slot) != EntityHandles::NULL_ENTITY) {
+      live.push_back(slot);
+    }
+  }
+  std::ranges::sort(live, {}, [&handles](uint32_t slot) {
+    return handles.slotEntity(slot);
+  });
+  writer.value(static_cast<uint32_t>(live.size()));
+  writer.values(std::span<const uint32_t>(live));
+
+  std::vector<Entity> entities(live.size());
+  std::ranges::transform(live, entities.begin(), [&handles](uint32_t slot) {
+    return handles.slotEntity(slot);
+  });
+  saveComponents(SnapshotComponents{}, writer, ecs, entities, assets);
+}
+
+bool validateEntities(SnapshotReader &reader, const TextureAssets &assets) {
+  // Counts are checked against what is left before anything is allocated.
+  auto readSlots = [&reader](std::vector<uint32_t> &slots) {
+    uint32_t n = 0;
+    reader.value(n);
+    if (not reader.good() || reader.remaining() / sizeof(uint32_t) < n) {
+      return false;
+    }
+    slots.resize(n);
+    reader.values(std::span(slots));
+    return true;
+  };
+  std::vector<uint32_t> generations;
+  std::vector<uint32_t> free_slots;
+  std::vector<uint32_t> live;
+  if (not readSlots(generations) || not readSlots(free_slots) ||
+      not readSlots(live)) {
+    return false;
+  }
+
+  // Every slot must be either free or live, and only once.
+  if (free_slots.size() + live.size() != generations.size()) {
+    return false;
+  }
+  std::vector<bool> used(generations.size(), false);
+  for (const auto slot : free_slots) {
+    if (slot >= used.size() || used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  for (const auto slot : live) {
+    if (slot >= used.size() || used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+
+  return validateComponents(SnapshotComponents{}, reader, live.size(),
+                            assets);
+}
+
+bool restoreEntities(SnapshotReader &reader, Coordinator &ecs,
+                     EntityHandles &handles, const TextureAssets &assets) {
+  uint32_t n_slots = 0;
+  reader.value(n_slots);
+  std::vector<uint32_t> generations(n_slots);
+  reader.values(std::span(generations));
+
+  uint32_t n_free = 0;
+  reader.value(n_free);
+  std::vector<uint32_t> free_slots(n_free);
+  reader.values(std::span(free_slots));
+
+  uint32_t n_live = 0;
+  reader.value(n_live);
+  std::vector<uint32_t> live(n_live);
+  reader.values(std::span(live));
+
+  const bool ordered = handles.restore(generations, free_slots, live);
+
+  std::vector<Entity> entities(live.size());
+  std::ranges::transform(live, entities.begin(), [&handles](uint32_t slot) {
+    return handles.slotEntity(slot);
+  });
+  restoreComponents(SnapshotComponents{}, reader, ecs, entities, assets);
+  return ordered;
+}
+
+bool writeSnapshotFile(const std::string &path,
+                       std::span<const std::byte> data) {
+  FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool written =
+      std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  return std::fclose(file) == 0 && written;
+}
+
+bool readSnapshotFile(const std::string &path, std::vector<std::byte> &data) {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::array<std::byte, 64 * 1024> chunk{};
+  data.clear();
+  size_t n_read = 0;
+  while ((n_read = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+    data.insert(data.end(), chunk.begin(), chunk.begin() + n_read);
+  }
+  const bool read = std::ferror(file) == 0;
+  std::ignore = std::fclose(file);
+  return read;
+}
@@ -0,0 +1,123 @@
+#ifndef GAME_SNAPSHOT_HPP
+#define GAME_SNAPSHOT_HPP
+
+#include "entity_handles.hpp"
+#include "texture_assets.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <tecs.hpp>
+#include <type_traits>
+#include <vector>
+
+using namespace Tecs;
+
+// Snapshots are flat binary blobs: a header, the entity handle table, each
+// component's values packed one after another, then whatever other state the
+// game appends. Everything is copied with memcpy, so snapshots are only
+// portable between builds of the same game on the same platform.
+
+// Appends plain values to a snapshot. Reusing the buffer for each snapshot
+// avoids reallocating it.
+class SnapshotWriter {
+public:
+  // Clears the buffer & writes the header.
+  SnapshotWriter(std::vector<std::byte> &data, int32_t level);
+
+  template <class T> void value(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write(&value, sizeof(T));
+  }
+  template <class T> void values(std::span<const T> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write(values.data(), values.size_bytes());
+  }
+
+  // Record the final size in the header: call once everything is written.
+  void finish();
+
+private:
+  std::vector<std::byte> &data;
+
+  void write(const void *source, size_t size) {
+    const size_t offset = data.size();
+    data.resize(offset + size);
+    std::memcpy(data.data() + offset, source, size);
+  }
+};
+
+// Reads values back in the order they were written. Reading past the end
+// leaves values as they were, and marks the reader as no longer good.
+class SnapshotReader {
+public:
+  // Checks the header, returning nothing if this isn't a complete snapshot.
+  static std::optional<SnapshotReader> open(std::span<const std::byte> data);
+
+  [[nodiscard]] int32_t level() const { return snapshot_level; }
+  [[nodiscard]] bool good() const { return not truncated; }
+  [[nodiscard]] size_t remaining() const { return data.size() - offset; }
+
+  template <class T> void value(T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    read(&value, sizeof(T));
+  }
+  template <class T> void values(std::span<T> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    read(values.data(), values.size_bytes());
+  }
+
+private:
+  std::span<const std::byte> data;
+  size_t offset = 0;
+  int32_t snapshot_level = 0;
+  bool truncated = false;
+
+  explicit SnapshotReader(std::span<const std::byte> data) : data(data) {}
+
+  void read(void *destination, size_t size) {
+    if (truncated || size > remaining()) {
+      truncated = true;
+      return;
+    }
+    std::memcpy(destination, data.data() + offset, size);
+    offset += size;
+  }
+};
+
+// Counts the bytes values would take up in a snapshot.
+class SnapshotSize {
+public:
+  template <class T> void value(const T & /*unused*/) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    total += sizeof(T);
+  }
+
+  [[nodiscard]] size_t size() const { return total; }
+
+private:
+  size_t total = 0;
+};
+
+// Save every live entity in the handle table, with all of its components.
+void saveEntities(SnapshotWriter &writer, Coordinator &ecs,
+                  const EntityHandles &handles, const TextureAssets &assets);
+// Read through the entities saved in a snapshot, checking that they can be
+// restored: that the handle table is consistent, and every component value is
+// in range. Returns false if anything is wrong or missing.
+bool validateEntities(SnapshotReader &reader, const TextureAssets &assets);
+// Replace every entity with those in the snapshot, which must have passed
+// validateEntities(). Handles saved with the snapshot refer to the restored
+// entities. Returns false if the coordinator reordered the entities, in which
+// case systems will visit them in a different order than when the snapshot
+// was taken.
+bool restoreEntities(SnapshotReader &reader, Coordinator &ecs,
+                     EntityHandles &handles, const TextureAssets &assets);
+
+bool writeSnapshotFile(const std::string &path,
+                       std::span<const std::byte> data);
+bool readSnapshotFile(const std::string &path, std::vector<std::byte> &data);
+
+#endif // GAME_SNAPSHOT_HPP
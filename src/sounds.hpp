@@ -0,0 +1,19 @@
+#ifndef GAME_SOUNDS_HPP
+#define GAME_SOUNDS_HPP
+
+#include <SDL2/SDL_mixer.h>
+
+// Sound effects. Headless worlds have none.
+struct Sounds {
+  Mix_Chunk *shoot = nullptr;
+  Mix_Chunk *explosion = nullptr;
+  Mix_Chunk *hit = nullptr;
+};
+
+inline void playSound(Mix_Chunk *sound) {
+  if (sound != nullptr) {
+    Mix_PlayChannel(-1, sound, 0);
+  }
+}
+
+#endif // GAME_SOUNDS_HPP
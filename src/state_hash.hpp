@@ -0,0 +1,37 @@
+#ifndef GAME_STATE_HASH_HPP
+#define GAME_STATE_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+// 64-bit FNV-1a over plain values, taking them the same way as SnapshotWriter.
+// Not cryptographic: only for telling whether two runs diverged.
+class StateHash {
+public:
+  template <class T> void value(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    bytes(&value, sizeof(T));
+  }
+  template <class T> void values(std::span<const T> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    bytes(values.data(), values.size_bytes());
+  }
+
+  [[nodiscard]] uint64_t digest() const { return hash; }
+
+private:
+  static constexpr uint64_t OFFSET_BASIS = 0xCBF29CE484222325;
+  static constexpr uint64_t PRIME = 0x100000001B3;
+  uint64_t hash = OFFSET_BASIS;
+
+  void bytes(const void *data, size_t size) {
+    const auto *byte = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ byte[i]) * PRIME;
+    }
+  }
+};
+
+#endif // GAME_STATE_HASH_HPP
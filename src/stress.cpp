@@ -0,0 +1,58 @@
+#include "stress.hpp"
+#include <algorithm>
+#include <cstdio>
+
+StressTest::StressTest(const StressOptions &options)
+    : options(options), start(Clock::now()), previous_frame(start),
+      second_start(start) {}
+
+void StressTest::configure(WorldConfig &config) const {
+  config.alien_rows = options.alien_rows;
+  config.alien_columns = options.alien_columns;
+  config.fit_aliens = true;
+  config.wave_period = options.wave_period;
+  config.player_fire_period = options.player_fire_period;
+  config.enemy_fire_spacing = options.enemy_fire_spacing;
+  config.hit_stop = false;
+  config.endless = true;
+}
+
+bool StressTest::frame(size_t n_entities) {
+  const auto now = Clock::now();
+  const Duration frame_time = now - previous_frame;
+  previous_frame = now;
+  frame_times.add(frame_time);
+  second_frame_times.add(frame_time);
+  n_frames++;
+  second_frames++;
+  most_entities = std::max(most_entities, n_entities);
+
+  const Duration second = now - second_start;
+  if (second >= 1s) {
+    const double fps = static_cast<double>(second_frames) / second.count();
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    printf("Stress: %6.1fs %7zu entities %7.1f fps, worst frame %.2fms\n",
+           Duration(now - start).count(), n_entities, fps,
+           Milliseconds(second_frame_times.max).count());
+    if (fps >= options.target_fps) {
+      most_sustained_entities = std::max(most_sustained_entities, n_entities);
+    }
+    second_start = now;
+    second_frames = 0;
+    second_frame_times = {};
+  }
+  return now - start < options.duration;
+}
+
+void StressTest::printSummary() const {
+  const Duration elapsed = previous_frame - start;
+  if (n_frames == 0 || elapsed <= Duration::zero()) {
+    return;
+  }
+  printf("Stress: %llu frames in %.1fs, %.1f fps on average\n",
+         static_cast<unsigned long long>(n_frames), elapsed.count(),
+         static_cast<double>(n_frames) / elapsed.count());
+  printf("Stress: at most %zu entities, and %zu while keeping up %.0f fps\n",
+         most_entities, most_sustained_entities, options.target_fps);
+  frame_times.print("Stress frame time");
+}
@@ -0,0 +1,60 @@
+#ifndef GAME_STRESS_HPP
+#define GAME_STRESS_HPP
+
+#include "frame_pacer.hpp"
+#include "world.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <tecs.hpp>
+
+using namespace Tecs;
+using namespace std::literals::chrono_literals;
+
+// An endless game, played by the bot, where wave after wave of aliens arrives
+// without waiting for the last to be cleared, so the number of entities keeps
+// growing. Frames are run back to back rather than paced, to find how many
+// entities the game can keep up with.
+struct StressOptions {
+  // Each wave, fitted to the window however big it is.
+  int alien_rows = 10;
+  int alien_columns = 40;
+  Duration wave_period = 5s;
+  Duration player_fire_period = 100ms;
+  int enemy_fire_spacing = 300;
+  // How long the run lasts.
+  Duration duration = 120s;
+  // The frame rate counted as keeping up.
+  double target_fps = 60;
+};
+
+// Reports the frame rate & entity count every second of a stress run, and
+// sums them up at the end.
+class StressTest {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit StressTest(const StressOptions &options);
+
+  // Overrides how the run's one endless level is set up.
+  void configure(WorldConfig &config) const;
+  // Count a frame, once it is finished. Returns false when the run is over.
+  bool frame(size_t n_entities);
+
+  void printSummary() const;
+
+private:
+  StressOptions options;
+  Clock::time_point start;
+  Clock::time_point previous_frame;
+  Clock::time_point second_start;
+  uint64_t n_frames = 0;
+  uint64_t second_frames = 0;
+  DurationStatistics second_frame_times;
+  DurationStatistics frame_times;
+  size_t most_entities = 0;
+  // The most entities there were at the end of a second that kept up.
+  size_t most_sustained_entities = 0;
+};
+
+#endif // GAME_STRESS_HPP
@@ -0,0 +1,586 @@
+#ifndef GAME_SYSTEMS_HPP
+#define GAME_SYSTEMS_HPP
+
+#include "collision_bounds.hpp"
+#include "components.hpp"
+#include "contacts.hpp"
+#include "destructible.hpp"
+#include "draw_commands.hpp"
+#include "entity_handles.hpp"
+#include "fixed_point.hpp"
+#include "game_event.hpp"
+#include "input.hpp"
+#include "particles.hpp"
+#include "pipeline.hpp"
+#include "prefabs.hpp"
+#include "rectangle.hpp"
+#include "render_layers.hpp"
+#include "sounds.hpp"
+#include <SDL2/SDL_render.h>
+#include <memory_resource>
+#include <set>
+#include <tecs.hpp>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace Tecs;
+
+struct LifeTimeSystem final : System {
+  static constexpr Stage STAGE = Stage::Destruction;
+  using Required = ComponentList<LifeTime>;
+  using Excluded = ComponentList<>;
+
+  EntityHandles &handles;
+
+  LifeTimeSystem(Coordinator &coord, EntityHandles &handles)
+      : System(signatureOf<LifeTimeSystem>(coord), coord), handles(handles) {}
+
+  void run(const std::set<Entity> &entities, Coordinator &coord,
+           const Duration delta) override {
+    auto [lifetimes] = componentStorage<LifeTime>(coord);
+    for (const auto &e : entities) {
+      auto &lifetime = lifetimes[e];
+      lifetime.lived += delta;
+      if (lifetime.lived >= lifetime.lifespan) {
+        handles.destroy(e);
+      }
+    }
+  }
+};
+struct AlienEncroachmentSystem final : System {
+  static constexpr Stage STAGE = Stage::Collision;
+  using Required = ComponentList<Alien, Position>;
+  using Excluded = ComponentList<>;
+
+  int border;
+  GameEvents &events;
+  EntityHandles &handles;
+  // Aliens past the border are removed, rather than ending the game.
+  bool endless;
+  AlienEncroachmentSystem(Tecs::Coordinator &coord, const int window_height,
+                          GameEvents &events, EntityHandles &handles,
+                          bool endless)
+      : System(signatureOf<AlienEncroachmentSystem>(coord), coord),
+        border{window_height - 80}, events(events), handles(handles),
+        endless(endless) {}
+  void run(const std::set<Entity> &aliens, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    auto [positions] = componentStorage<Position>(ecs);
+    for (const auto &e : aliens) {
+      if (positions[e].p.y > border) {
+        if (endless) {
+          handles.destroy(e);
+        } else {
+          events.push_back(GameEvent::GameOver);
+        }
+      }
+    }
+  }
+};
+struct DeathSystem final : System {
+  static constexpr Stage STAGE = Stage::Destruction;
+  using Required = ComponentList<Health>;
+  using Excluded = ComponentList<>;
+
+  static constexpr size_t EXPLOSION_PARTICLES = 2000;
+
+  EntityHandles &handles;
+  ParticlePool &particles;
+
+  const std::pmr::vector<EntityHandle> &barriers;
+  GameEvents &events;
+
+  DeathSystem(Coordinator &coord, EntityHandles &handles,
+              ParticlePool &particles,
+              const std::pmr::vector<EntityHandle> &barriers,
+              GameEvents &events)
+      : System(signatureOf<DeathSystem>(coord), coord), handles(handles),
+        particles(particles), barriers(barriers),
+        events(events) {}
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    for (const auto &e : entities) {
+      const auto &health = ecs.getComponent<Health>(e);
+      if (health.current <= 0.0) {
+        handles.destroy(e);
+
+        bool explosive = true;
+        if (ecs.hasComponent<Player>(e)) {
+          events.push_back(GameEvent::GameOver);
+        } else if (ecs.hasComponent<Alien>(e)) {
+          events.push_back(GameEvent::Scored);
+        } else if (ecs.hasComponent<Mothership>(e)) {
+          events.push_back(GameEvent::KilledMothership);
+        } else {
+          explosive = false;
+        }
+
+        if (explosive) {
+          particles.emit({
+              ecs.getComponent<Position>(e).p,
+              EXPLOSION_PARTICLES,
+              20,
+              260,
+              0.3,
+              0.9,
+          });
+        }
+      }
+    }
+  }
+};
+
+// Finds every overlapping pair of entities that share a layer, then resolves
+// them in separate passes over the contacts: damage, sounds, then the rules.
+struct CollisionSystem final : System {
+  static constexpr Stage STAGE = Stage::Collision;
+  using Required = ComponentList<Health, Position, CollisionBounds>;
+  using Excluded = ComponentList<>;
+
+  Contacts &contacts;
+  GameEvents &events;
+  EntityHandles &handles;
+  const Sounds &sounds;
+  // Pause briefly when the player is hit, if anyone is watching.
+  bool hit_stop;
+  // The player can't be hurt, and aliens that land are removed rather than
+  // ending the game.
+  bool endless;
+
+  CollisionSystem(Coordinator &coord, Contacts &contacts,
+                  GameEvents &events, EntityHandles &handles,
+                  const Sounds &sounds, bool hit_stop, bool endless)
+      : System(signatureOf<CollisionSystem>(coord), coord),
+        contacts(contacts), events(events), handles(handles), sounds(sounds),
+        hit_stop(hit_stop), endless(endless) {}
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    contacts.clear();
+    findContacts(entities, ecs);
+    applyDamage(ecs);
+    playContactSounds(ecs);
+    applyRules(ecs);
+  }
+
+  void findContacts(const std::set<Entity> &entities, Coordinator &ecs) {
+    auto [positions, all_bounds] =
+        componentStorage<Position, CollisionBounds>(ecs);
+    for (const auto &a : entities) {
+      const auto aRect = all_bounds[a].rectangle(positions[a]);
+      const auto aLayer = all_bounds[a].layer;
+      for (const auto &b : entities) {
+        if (b == a) {
+          break;
+        }
+
+        const auto bRect = all_bounds[b].rectangle(positions[b]);
+        const auto layers = aLayer & all_bounds[b].layer;
+        if (not rectangleIntersection(aRect, bRect) || layers.none()) {
+          continue;
+        }
+        Contact contact{a, b, layers, overlapCentre(aRect, bRect), false};
+        const bool a_destructible = ecs.hasComponent<Destructible>(a);
+        if (a_destructible || ecs.hasComponent<Destructible>(b)) {
+          if (not a_destructible) {
+            std::swap(contact.a, contact.b);
+          }
+          // Only solid pixels collide.
+          const auto &destructible =
+              ecs.getComponent<Destructible>(contact.a);
+          const auto area = destructible.spriteArea(
+              positions[contact.a], a_destructible ? bRect : aRect);
+          if (not destructible.firstSolid(area, true).has_value()) {
+            continue;
+          }
+          contact.destructible = true;
+        }
+        contacts.push_back(contact);
+      }
+    }
+  }
+
+  // Contacts that miss are dropped.
+  void applyDamage(Coordinator &ecs) {
+    auto [healths, positions, all_bounds] =
+        componentStorage<Health, Position, CollisionBounds>(ecs);
+    auto damage = [&](Entity e) {
+      if (not endless || not ecs.hasComponent<Player>(e)) {
+        healths[e].current -= 1.0;
+      }
+    };
+    size_t kept = 0;
+    for (const auto &contact : contacts) {
+      if (contact.destructible) {
+        // Solid pixels are knocked out instead of the destructible losing
+        // health. An earlier contact may have already knocked out the ones
+        // this one found.
+        if (not erodeDestructible(
+                ecs.getComponent<Destructible>(contact.a),
+                positions[contact.a],
+                all_bounds[contact.b].rectangle(positions[contact.b]))) {
+          continue;
+        }
+        damage(contact.b);
+      } else {
+        damage(contact.a);
+        damage(contact.b);
+      }
+      contacts[kept++] = contact;
+    }
+    contacts.resize(kept);
+  }
+
+  // Returns whether the area hit a solid pixel of the destructible.
+  static bool erodeDestructible(Destructible &destructible,
+                                const Position &pos, const Rectangle &area) {
+    // Things coming from above hit the top of the solid pixels first.
+    const bool downwards = area.y + area.h / 2 < pos.p.y;
+    const auto hit = destructible.firstSolid(
+        destructible.spriteArea(pos, area), downwards);
+    if (hit.has_value()) {
+      destructible.erode(*hit);
+    }
+    return hit.has_value();
+  }
+
+  // Played once health is settled for the frame, so whatever was destroyed
+  // explodes.
+  void playContactSounds(Coordinator &ecs) const {
+    auto [healths] = componentStorage<Health>(ecs);
+    bool player_hit = false;
+    for (const auto &contact : contacts) {
+      if (contact.destructible) {
+        playSound(sounds.hit);
+      } else if (ecs.hasComponent<Player>(contact.a) ||
+                 ecs.hasComponent<Player>(contact.b)) {
+        playSound(sounds.explosion);
+        player_hit = true;
+      } else if (healths[contact.a].current > 0 ||
+                 healths[contact.b].current > 0) {
+        playSound(sounds.hit);
+      } else {
+        playSound(sounds.explosion);
+      }
+    }
+    if (player_hit && hit_stop) {
+      std::this_thread::sleep_for(10 * FRAME_DURATION);
+    }
+  }
+
+  void applyRules(Coordinator &ecs) {
+    // Layer 0x4 is shared by the player, the aliens & the barriers, which
+    // otherwise never touch: an alien reaching the player or a barrier has
+    // landed.
+    for (const auto &contact : contacts) {
+      if ((contact.layers & LayerMask{0x4}).none()) {
+        continue;
+      }
+      if (not endless) {
+        events.push_back(GameEvent::GameOver);
+        continue;
+      }
+      for (const auto e : {contact.a, contact.b}) {
+        if (ecs.hasComponent<Alien>(e)) {
+          handles.destroy(e);
+        }
+      }
+    }
+  }
+};
+struct HealthBarSystem final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = ComponentList<Health, HealthBar, Position>;
+  using Excluded = ComponentList<Layered>;
+
+  DrawCommandBuffers &buffers;
+
+  HealthBarSystem(Coordinator &coord, DrawCommandBuffers &buffers)
+      : System(signatureOf<HealthBarSystem>(coord), coord), buffers{buffers} {}
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    auto [healths, bars, positions] =
+        componentStorage<Health, HealthBar, Position>(ecs);
+    auto &draw_list = buffers.back().scene;
+    for (const auto &e : entities) {
+      drawHealthBar(draw_list, positions[e].p, healths[e], bars[e]);
+    }
+  }
+};
+
+struct PlayerControlSystem final : System {
+  static constexpr Stage STAGE = Stage::Control;
+  using Required = ComponentList<Player, Velocity, Position>;
+  using Excluded = ComponentList<>;
+
+  const int window_width;
+  static constexpr Duration FIRE_FREQUENCY = 500ms;
+  // Time between shots.
+  const Duration fire_period;
+  Duration shot_delta;
+  const Prefab &bullet;
+  EntityHandles &handles;
+  const Input &input;
+  const Sounds &sounds;
+
+  PlayerControlSystem(Coordinator &coord, const int windowWidth,
+                      Duration fire_period, const Prefab &bullet,
+                      EntityHandles &handles, const Input &input,
+                      const Sounds &sounds)
+      : System(signatureOf<PlayerControlSystem>(coord), coord),
+        window_width(windowWidth), fire_period(fire_period),
+        shot_delta(fire_period), bullet(bullet),
+        handles(handles), input(input), sounds(sounds) {}
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    constexpr float PLAYER_MAX_SPEED = 300;
+    for (const auto &e : entities) {
+      auto &[velocity] = ecs.getComponent<Velocity>(e);
+
+      if (input.left) {
+        velocity.x = -PLAYER_MAX_SPEED;
+      } else if (input.right) {
+        velocity.x = PLAYER_MAX_SPEED;
+      } else {
+        velocity.x = 0;
+      }
+
+      auto &pos = ecs.getComponent<Position>(e);
+
+      // Handle firing.
+      shot_delta += delta;
+
+      if (input.fire && shot_delta >= fire_period) {
+        playSound(sounds.shoot);
+        bullet.spawn(ecs, handles, pos);
+        shot_delta = Duration::zero();
+      }
+
+      constexpr int WINDOW_MARGIN = 50;
+      if (pos.p.x > (float)window_width - WINDOW_MARGIN) {
+        pos.p.x = (float)window_width - WINDOW_MARGIN;
+        velocity.x = 0;
+      } else if (pos.p.x < WINDOW_MARGIN) {
+        pos.p.x = WINDOW_MARGIN;
+        velocity.x = 0;
+      }
+    }
+  }
+};
+struct VelocitySystem final : public System {
+  static constexpr Stage STAGE = Stage::Movement;
+  using Required = ComponentList<Velocity, Position>;
+  using Excluded = ComponentList<>;
+
+  explicit VelocitySystem(Coordinator &coord)
+      : System(signatureOf<VelocitySystem>(coord), coord) {}
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    auto [positions, velocities] = componentStorage<Position, Velocity>(ecs);
+    for (const auto &e : entities) {
+      auto &[pos] = positions[e];
+      const auto &[vel] = velocities[e];
+
+      pos = integrate(pos, vel, delta);
+    }
+  }
+};
+struct OffscreenSystem final : System {
+  static constexpr Stage STAGE = Stage::Destruction;
+  using Required = ComponentList<Position, CollisionBounds>;
+  using Excluded = ComponentList<>;
+
+  Rectangle screen_space;
+  EntityHandles &handles;
+  GameEvents &events;
+  EntityHandle mothership = NULL_HANDLE;
+
+  OffscreenSystem(Tecs::Coordinator &coord, int width, int height,
+                  EntityHandles &handles, GameEvents &events)
+      : System(signatureOf<OffscreenSystem>(coord), coord),
+        screen_space{0, 0, static_cast<float>(width),
+                     static_cast<float>(height)},
+        handles(handles), events(events) {}
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    auto [positions, all_bounds] =
+        componentStorage<Position, CollisionBounds>(ecs);
+    for (const auto &e : entities) {
+      if (not rectangleIntersection(screen_space,
+                                    all_bounds[e].rectangle(positions[e]))) {
+        if (handles.handle(e) == mothership) {
+          events.push_back(GameEvent::MothershipLeft);
+        }
+        handles.destroy(e);
+      }
+    }
+  }
+};
+
+// Records updates to the textures of damaged destructibles, and has their
+// layers redrawn. Must run before the layer rendering system.
+struct DestructibleRenderingSystem final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = ComponentList<Destructible, Layered, RenderCopy>;
+  using Excluded = ComponentList<>;
+
+  DrawCommandBuffers &buffers;
+  LayerRenderingSystem &layers;
+  const SDL_Surface *image;
+  bool redraw_all = false;
+
+  DestructibleRenderingSystem(Coordinator &coord, DrawCommandBuffers &buffers,
+                              LayerRenderingSystem &layers,
+                              const SDL_Surface *image)
+      : System(signatureOf<DestructibleRenderingSystem>(coord), coord),
+        buffers(buffers), layers(layers), image(image) {}
+
+  // Update the whole of every texture, as after a restore.
+  void invalidate() { redraw_all = true; }
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    auto [destructibles, layereds, render_copies] =
+        componentStorage<Destructible, Layered, RenderCopy>(ecs);
+    auto &updates = buffers.back().mask_updates;
+    for (const auto &e : entities) {
+      auto &destructible = destructibles[e];
+      if (redraw_all) {
+        destructible.dirty = {0, 0, destructible.width, destructible.height};
+      }
+      if (destructible.dirty.w <= 0 || destructible.dirty.h <= 0) {
+        continue;
+      }
+      if (image != nullptr) {
+        updates.push_back({render_copies[e].texture, image, destructible.dirty,
+                           destructible.rows});
+      }
+      destructible.dirty = {};
+      layers.invalidate(layereds[e].layer);
+    }
+    redraw_all = false;
+  }
+};
+
+struct StaticSpriteRenderingSystem final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = ComponentList<Position, RenderCopy>;
+  using Excluded = ComponentList<Animation, Layered>;
+
+  DrawCommandBuffers &buffers;
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    auto [positions, render_copies] =
+        componentStorage<Position, RenderCopy>(ecs);
+    auto &draw_list = buffers.back().scene;
+    for (const auto &e : entities) {
+      const auto &[pos] = positions[e];
+      const auto &render_copy = render_copies[e];
+      const SDL_Rect renderRect = centered_rectangle(
+          {(int)pos.x, (int)pos.y, render_copy.w, render_copy.h});
+      draw_list.sprite(render_copy.texture, renderRect);
+    }
+  }
+
+  StaticSpriteRenderingSystem(Coordinator &coord, DrawCommandBuffers &buffers)
+      : System(signatureOf<StaticSpriteRenderingSystem>(coord), coord),
+        buffers(buffers) {}
+};
+
+struct AnimatedSpriteRenderingSystem final : System {
+  static constexpr Stage STAGE = Stage::Recording;
+  using Required = ComponentList<Position, RenderCopy, Animation>;
+  using Excluded = ComponentList<>;
+
+  DrawCommandBuffers &buffers;
+
+  // Animation must be added before RenderCopy, so the static renderer doesn't
+  // get it.
+  AnimatedSpriteRenderingSystem(Coordinator &coord,
+                                DrawCommandBuffers &buffers)
+      : System(signatureOf<AnimatedSpriteRenderingSystem>(coord), coord),
+        buffers(buffers) {}
+
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    auto [positions, render_copies, animations] =
+        componentStorage<Position, RenderCopy, Animation>(ecs);
+    auto &draw_list = buffers.back().scene;
+    for (const auto &e : entities) {
+      auto &animation = animations[e];
+
+      // Update animation step & step frames as appropriate.
+      if (animation.current_step_time >= animation.step_time) {
+        animation.step++;
+        animation.current_step_time -= animation.step_time;
+
+        if (animation.step >= animation.n_steps) {
+          animation.step = 0;
+        }
+
+        // Assuming sprites are in a horizontal line and of uniform size,
+        // only the x component of the source rectangle needs updating.
+        animation.src_rect.x = animation.step * animation.src_rect.w;
+      }
+
+      const auto &pos = positions[e].p;
+      const auto &render_copy = render_copies[e];
+      const SDL_Rect renderRect = centered_rectangle(
+          {(int)pos.x, (int)pos.y, render_copy.w, render_copy.h});
+
+      draw_list.sprite(render_copy.texture, animation.src_rect, renderRect);
+
+      animation.current_step_time += delta;
+    }
+  }
+};
+
+struct EnemyShootingSystem final : System {
+  static constexpr Stage STAGE = Stage::Control;
+  using Required = ComponentList<Alien, Position>;
+  using Excluded = ComponentList<>;
+
+  // On average, half this many aliens are passed over between shots.
+  static constexpr int FIRE_SPACING = 3000;
+
+  EnemyShootingSystem(Coordinator &coord, EntityHandles &handles,
+                      const Prefab &enemy_bullet, const Sounds &sounds,
+                      uint32_t seed, int fire_spacing)
+      : System(signatureOf<EnemyShootingSystem>(coord), coord),
+        handles(handles), sounds(sounds), enemyBullet{enemy_bullet},
+        gen{seed}, fire_spacing{fire_spacing} {}
+  EntityHandles &handles;
+  const Sounds &sounds;
+  const Prefab &enemyBullet;
+  MersenneTwister gen;
+  int fire_spacing;
+  int nextFire = 0;
+  void run(const std::set<Entity> &entities, Coordinator &ecs,
+           const Duration delta) override {
+    std::ignore = delta;
+    for (const auto &e : entities) {
+      // Generate a binomially distributed random number indicating how many
+      // aliens to go along before firing.
+      if (nextFire <= 0) {
+        playSound(sounds.shoot);
+        enemyBullet.spawn(ecs, handles, ecs.getComponent<Position>(e));
+        nextFire = binomialHalf(gen, fire_spacing);
+      } else {
+        nextFire -= 1;
+      }
+    }
+  }
+};
+
+#endif // GAME_SYSTEMS_HPP
@@ -0,0 +1,39 @@
+#ifndef GAME_TEXTURE_ASSETS_HPP
+#define GAME_TEXTURE_ASSETS_HPP
+
+#include <SDL2/SDL_render.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Gives textures IDs that can be saved in place of pointers. IDs are handed
+// out in the order textures are added, so they are the same from run to run
+// as long as the game loads its textures in the same order.
+class TextureAssets {
+public:
+  static constexpr uint32_t NO_TEXTURE = 0;
+
+  SDL_Texture *add(SDL_Texture *texture) {
+    textures.push_back(texture);
+    return texture;
+  }
+
+  // NO_TEXTURE for textures that weren't added, such as rendered text.
+  [[nodiscard]] uint32_t id(SDL_Texture *texture) const {
+    const auto found = std::ranges::find(textures, texture);
+    return found == textures.end()
+               ? NO_TEXTURE
+               : static_cast<uint32_t>(found - textures.begin()) + 1;
+  }
+  // Whether an ID is NO_TEXTURE or was handed out, even if for a null texture.
+  [[nodiscard]] bool known(uint32_t id) const { return id <= textures.size(); }
+  [[nodiscard]] SDL_Texture *texture(uint32_t id) const {
+    return id == NO_TEXTURE || id > textures.size() ? nullptr
+                                                    : textures[id - 1];
+  }
+
+private:
+  std::vector<SDL_Texture *> textures;
+};
+
+#endif // GAME_TEXTURE_ASSETS_HPP
@@ -0,0 +1,55 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t n_threads) {
+  threads.reserve(n_threads);
+  for (size_t i = 0; i < n_threads; ++i) {
+    threads.emplace_back([this] {
+      while (true) {
+        std::function<void()> job;
+        {
+          std::unique_lock lock(mutex);
+          job_available.wait(lock,
+                             [this] { return stopping || not jobs.empty(); });
+          if (jobs.empty()) {
+            return;
+          }
+          job = std::move(jobs.front());
+          jobs.pop_front();
+          running++;
+        }
+
+        job();
+
+        const std::scoped_lock lock(mutex);
+        running--;
+        if (running == 0 && jobs.empty()) {
+          all_finished.notify_all();
+        }
+      }
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::scoped_lock lock(mutex);
+    stopping = true;
+  }
+  job_available.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+  {
+    const std::scoped_lock lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  job_available.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock lock(mutex);
+  all_finished.wait(lock, [this] { return running == 0 && jobs.empty(); });
+}
@@ -0,0 +1,35 @@
+#ifndef GAME_THREAD_POOL_HPP
+#define GAME_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads taking jobs from a shared queue, in the order they
+// were submitted.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t n_threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> job);
+  // Block until every submitted job has finished.
+  void wait();
+
+private:
+  std::mutex mutex;
+  std::condition_variable job_available;
+  std::condition_variable all_finished;
+  std::deque<std::function<void()>> jobs;
+  size_t running = 0;
+  bool stopping = false;
+  std::vector<std::thread> threads;
+};
+
+#endif // GAME_THREAD_POOL_HPP
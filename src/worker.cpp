@@ -0,0 +1,19 @@
+#include "worker.hpp"
+
+Worker::Worker(std::function<void()> job)
+    : job(std::move(job)), thread([this] {
+        while (true) {
+          started.acquire();
+          if (stopping) {
+            return;
+          }
+          this->job();
+          finished.release();
+        }
+      }) {}
+
+Worker::~Worker() {
+  stopping = true;
+  started.release();
+  thread.join();
+}
@@ -0,0 +1,30 @@
+#ifndef GAME_WORKER_HPP
+#define GAME_WORKER_HPP
+
+#include <atomic>
+#include <functional>
+#include <semaphore>
+#include <thread>
+
+// A thread that runs the same job each time it is started. Starting and
+// waiting are the only synchronisation: anything written before start() is
+// visible to the job, and anything the job writes is visible after wait().
+class Worker {
+public:
+  explicit Worker(std::function<void()> job);
+  ~Worker();
+  Worker(const Worker &) = delete;
+  Worker &operator=(const Worker &) = delete;
+
+  void start() { started.release(); }
+  void wait() { finished.acquire(); }
+
+private:
+  std::function<void()> job;
+  std::binary_semaphore started{0};
+  std::binary_semaphore finished{0};
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+#endif // GAME_WORKER_HPP
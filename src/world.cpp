@@ -0,0 +1,407 @@
+#include "world.hpp"
+#include "collision_bounds.hpp"
+#include "components.hpp"
+#include "destructible.hpp"
+#include "fixed_point.hpp"
+#include "prefabs.hpp"
+#include "snapshot.hpp"
+#include "state_hash.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <mutex>
+
+namespace {
+// Seeds for each of a level's RNGs.
+std::array<uint32_t, 3> levelSeeds(uint64_t seed, int level) {
+  std::seed_seq sequence{static_cast<uint32_t>(seed),
+                         static_cast<uint32_t>(seed >> 32),
+                         static_cast<uint32_t>(level)};
+  std::array<uint32_t, 3> seeds{};
+  sequence.generate(seeds.begin(), seeds.end());
+  return seeds;
+}
+
+bool registerComponents(Coordinator &ecs) {
+  // Worlds may be created on several threads at once, and tecs isn't known to
+  // make registering components thread-safe, so they take turns.
+  static std::mutex registration;
+  const std::scoped_lock lock(registration);
+
+  ecs.registerComponent<Position>();
+  ecs.registerComponent<RenderCopy>();
+  ecs.registerComponent<Velocity>();
+  ecs.registerComponent<Player>();
+  ecs.registerComponent<Health>();
+  ecs.registerComponent<HealthBar>();
+  ecs.registerComponent<Alien>();
+  ecs.registerComponent<CollisionBounds>();
+  ecs.registerComponent<Animation>();
+  ecs.registerComponent<LifeTime>();
+  ecs.registerComponent<Mothership>();
+  ecs.registerComponent<Layered>();
+  ecs.registerComponent<Destructible>();
+  return true;
+}
+
+// Fills in whatever the config leaves to the level's record.
+WorldConfig levelConfig(WorldConfig config, const PrefabFile &prefabs) {
+  const auto level = prefabs.level(config.level);
+  if (config.alien_rows == 0) {
+    config.alien_rows = level.alien_rows;
+  }
+  if (config.alien_columns == 0) {
+    config.alien_columns = level.alien_columns;
+  }
+  if (config.alien_speed == 0) {
+    config.alien_speed = level.alien_speed;
+  }
+  return config;
+}
+
+PrefabTextures prefabTextures(const WorldAssets &assets) {
+  return {
+      nullptr,          assets.player,       assets.aliens[0],
+      assets.aliens[1], assets.aliens[2],    assets.bullet,
+      assets.enemy_bullet, assets.mothership,
+  };
+}
+} // namespace
+
+World::World(const WorldConfig &config, const WorldAssets &assets)
+    : config(levelConfig(config, *assets.prefabs)), assets(assets),
+      components_registered(registerComponents(coordinator)),
+      entity_handles(coordinator, &arena), draw_commands(&arena),
+      events(frame_arena.resource()), frame_contacts(&arena),
+      player_score(config.score),
+      seeds(levelSeeds(config.seed, config.level)), alien_rng(seeds[0]),
+      mothership_rng(seeds[2]), wave_positions(&arena),
+      wave_aliens(&arena), barriers(&arena),
+      particles(config.presented ? MAX_PARTICLES : 0, seeds[0], &arena),
+      player_prefab(findPrefab(*assets.prefabs, "player",
+                               prefabTextures(assets))),
+      alien_prefab(findPrefab(*assets.prefabs, "alien",
+                              prefabTextures(assets))),
+      mothership_prefab(findPrefab(*assets.prefabs, "mothership",
+                                   prefabTextures(assets))),
+      bullet_prefab(findPrefab(*assets.prefabs, "player_bullet",
+                               prefabTextures(assets))),
+      enemy_bullet_prefab(findPrefab(*assets.prefabs, "enemy_bullet",
+                                     prefabTextures(assets))),
+      velocitySystem(coordinator),
+      playerControlSystem(coordinator, config.width,
+                          config.player_fire_period, bullet_prefab,
+                          entity_handles, input, this->assets.sounds),
+      // Aliens are counted in as each wave spawns.
+      alienMovementSystem(coordinator, 0, this->config.alien_speed, events,
+                          config.endless),
+      staticSpriteRenderingSystem(coordinator, draw_commands),
+      animatedSpriteRenderingSystem(coordinator, draw_commands),
+      healthBarSystem(coordinator, draw_commands),
+      deathSystem(coordinator, entity_handles, particles, barriers, events),
+      lifeTimeSystem(coordinator, entity_handles),
+      enemyShootingSystem(coordinator, entity_handles, enemy_bullet_prefab,
+                          this->assets.sounds, seeds[1],
+                          config.enemy_fire_spacing),
+      collisionSystem(coordinator, frame_contacts, events, entity_handles,
+                      this->assets.sounds, config.hit_stop, config.endless),
+      alienEncroachmentSystem(coordinator, config.height, events,
+                              entity_handles, config.endless),
+      offscreenSystem(coordinator, config.width, config.height,
+                      entity_handles, events),
+      layerRenderingSystem(coordinator, draw_commands,
+                           alienEncroachmentSystem.border, config.width),
+      destructibleRenderingSystem(coordinator, draw_commands,
+                                  layerRenderingSystem, assets.barrier_image),
+      simulationPipeline(playerControlSystem, alienMovementSystem,
+                         enemyShootingSystem, velocitySystem, collisionSystem,
+                         alienEncroachmentSystem, lifeTimeSystem,
+                         offscreenSystem, deathSystem),
+      recordingPipeline(destructibleRenderingSystem, layerRenderingSystem,
+                        staticSpriteRenderingSystem,
+                        animatedSpriteRenderingSystem, healthBarSystem) {
+  texture_assets.add(assets.player);
+  for (auto *texture : assets.aliens) {
+    texture_assets.add(texture);
+  }
+  for (auto *texture : assets.barriers) {
+    texture_assets.add(texture);
+  }
+  texture_assets.add(assets.bullet);
+  texture_assets.add(assets.enemy_bullet);
+  texture_assets.add(assets.mothership);
+
+  makeLevel();
+}
+
+void World::makeLevel() {
+  auto &ecs = coordinator;
+  auto &handles = entity_handles;
+
+  // Set up player.
+  auto player = player_prefab.spawn(
+      ecs, handles, {{config.width / 2, config.height - 40}});
+  player_handle = handles.handle(player);
+
+  // Add level & score text boxes. Their textures & sizes are filled in when
+  // the text is rendered.
+  Entity level_text_entity = handles.create();
+  level_text = handles.handle(level_text_entity);
+  ecs.addComponent<Layered>(level_text_entity);
+  ecs.getComponent<Layered>(level_text_entity).layer = Layer::Hud;
+  ecs.addComponent<RenderCopy>(level_text_entity);
+  ecs.addComponent<Position>(level_text_entity);
+
+  Entity score_entity = handles.create();
+  score_text = handles.handle(score_entity);
+  ecs.addComponent<Layered>(score_entity);
+  ecs.getComponent<Layered>(score_entity).layer = Layer::Hud;
+  ecs.addComponent<Position>(score_entity);
+  ecs.addComponent<RenderCopy>(score_entity);
+  ecs.getComponent<Position>(score_entity) = {{config.width / 2, 20}};
+
+  spawnAlienWave();
+
+  // Set up barriers.
+  constexpr int BARRIER_SCALE = 3;
+  const auto barrier_shape =
+      destructibleFromAlpha(assets.barrier_image, 32, 16, BARRIER_SCALE);
+  const int barrier_width = barrier_shape.width * BARRIER_SCALE;
+  const int barrier_height = barrier_shape.height * BARRIER_SCALE;
+  for (int i = 0; i < N_BARRIERS; ++i) {
+    auto barrier = handles.create();
+    barriers.push_back(handles.handle(barrier));
+    ecs.addComponent<Layered>(barrier);
+    ecs.getComponent<Layered>(barrier).layer = Layer::Barriers;
+    makeStaticSprite(
+        barrier, ecs,
+        {{config.width * (0.5 + i) / N_BARRIERS, config.height - 150}},
+        assets.barriers[i], barrier_width, barrier_height);
+
+    ecs.addComponent<Destructible>(barrier);
+    ecs.getComponent<Destructible>(barrier) = barrier_shape;
+    // Barriers are worn away rather than losing health.
+    ecs.addComponent<Health>(barrier);
+    ecs.getComponent<Health>(barrier) = {1.0, 1.0};
+    ecs.addComponent<CollisionBounds>(barrier);
+    ecs.getComponent<CollisionBounds>(barrier) = {
+        {barrier_width / 2, barrier_height / 2}, 0x3 | 0x4};
+  }
+}
+
+void World::spawnAlienWave() {
+  auto &ecs = coordinator;
+  const int rows = config.alien_rows;
+  const int columns = config.alien_columns;
+
+  // Rows are staggered, and each starts a little further along its shuffle.
+  // Fitted waves are squeezed together to keep that shuffle on screen, with
+  // the bottom row no lower than half way down. Positions are kept to whole
+  // pixels, as fixed point needs.
+  glm::vec2 scale{1, 1};
+  if (config.fit_aliens) {
+    constexpr float MARGIN = 50;
+    const float width = config.width - ALIEN_SHUFFLE_DISTANCE - MARGIN;
+    const float height = config.height / 2.0F - 60;
+    scale.x =
+        std::min(1.0F, width / static_cast<float>(columns * 50 + rows * 2));
+    scale.y = std::min(
+        1.0F, height / static_cast<float>(std::max(1, rows - 1) * 60));
+  }
+  // Reused by every wave, so the arena doesn't grow with each one.
+  auto &positions = wave_positions;
+  positions.clear();
+  for (int j = 1; j <= rows; ++j) {
+    for (int i = 1; i <= columns; ++i) {
+      // Off-sets the rows.
+      positions.push_back(
+          {{std::round(scale.x * static_cast<float>(i * 50 + j * 22)),
+            60 + std::round(scale.y * static_cast<float>((j - 1) * 60))}});
+    }
+  }
+  auto &aliens = wave_aliens;
+  aliens.clear();
+  alien_prefab.spawn(ecs, entity_handles, positions, aliens);
+  // Aliens that arrive later don't count as destroyed.
+  alienMovementSystem.initial_n_aliens += static_cast<int>(aliens.size());
+  alienMovementSystem.current_n_aliens += static_cast<uint32_t>(aliens.size());
+
+  // Whole ticks, so the phases are the same in every build.
+  const auto first_step = static_cast<uint32_t>(
+      std::chrono::round<Ticks>(FRAME_DURATION).count());
+  const auto last_step = static_cast<uint32_t>(
+      std::chrono::round<Ticks>(alien_prefab.component<Animation>().step_time)
+          .count());
+  const auto &alien_textures = assets.aliens;
+  auto [animations, alien_components, velocities, render_copies] =
+      componentStorage<Animation, Alien, Velocity, RenderCopy>(ecs);
+  for (size_t n = 0; n < aliens.size(); ++n) {
+    const auto alien = aliens[n];
+    const auto row = static_cast<int>(n) / columns;
+    animations[alien].current_step_time =
+        Ticks(uniformInt(alien_rng, first_step, last_step));
+    alien_components[alien].start_x =
+        positions[n].p.x -
+        std::round(scale.x * static_cast<float>((row + 1) * 20));
+    velocities[alien] = {{config.alien_speed, 0}};
+    render_copies[alien].texture =
+        alien_textures[alien_textures.size() * row / rows];
+  }
+}
+
+void World::simulate(const Input &frame_input, Duration delta) {
+  input = frame_input;
+  draw_commands.back().clear();
+
+  if (not mothership_active) {
+    if (uniformInt(mothership_rng, 0, 256) == 0) {
+      offscreenSystem.mothership = entity_handles.handle(
+          mothership_prefab.spawn(coordinator, entity_handles));
+      mothership_active = true;
+    }
+  }
+
+  if (config.wave_period > Duration::zero()) {
+    wave_time += simulationStep(delta);
+    if (wave_time >= config.wave_period) {
+      wave_time -= config.wave_period;
+      spawnAlienWave();
+    }
+  }
+
+  simulationPipeline.run(coordinator, simulationStep(delta));
+
+  // Prevent destroyed entities from rendering for an extra frame.
+  coordinator.destroyQueued();
+  particles.update(delta);
+
+  if (config.presented) {
+    recordingPipeline.run(coordinator, delta);
+    particles.record(draw_commands.back().particles);
+  }
+}
+
+GameEvent World::finishFrame() {
+  frame_number++;
+  score_changed = false;
+
+  const auto result = applyEvents();
+  // Hand the events' memory back before the arena is reset under it.
+  GameEvents(events.get_allocator()).swap(events);
+  frame_arena.reset();
+  return result;
+}
+
+GameEvent World::applyEvents() {
+  for (const auto &event : events) {
+    switch (event) {
+    case GameEvent::GameOver:
+      coordinator.destroyQueued();
+      return GameEvent::GameOver;
+    case GameEvent::Win:
+      return GameEvent::Win;
+    case GameEvent::MothershipLeft:
+      mothership_active = false;
+      break;
+    case GameEvent::KilledMothership:
+      mothership_active = false;
+      // Hacky way of giving 10 points for a mothership.
+      player_score += 9;
+      [[fallthrough]];
+    case GameEvent::Scored:
+      player_score += 1;
+      score_changed = true;
+      break;
+    case GameEvent::Quit:
+    case GameEvent::Progress:
+      break;
+    }
+  }
+  return GameEvent::Progress;
+}
+
+template <class Archive> void World::serialiseState(Archive &archive) {
+  archive.value(frame_number);
+  archive.value(player_score);
+  archive.value(mothership_active);
+  archive.value(mothership_rng);
+  archive.value(offscreenSystem.mothership);
+  archive.value(playerControlSystem.shot_delta);
+  archive.value(alien_rng);
+  archive.value(wave_time);
+  archive.value(alienMovementSystem.initial_n_aliens);
+  archive.value(alienMovementSystem.alien_speed);
+  archive.value(alienMovementSystem.current_n_aliens);
+  archive.value(enemyShootingSystem.gen);
+  archive.value(enemyShootingSystem.nextFire);
+}
+
+uint64_t World::stateHash() {
+  StateHash hash;
+  auto &ecs = coordinator;
+  for (uint32_t slot = 0; slot < entity_handles.capacity(); ++slot) {
+    const Entity entity = entity_handles.slotEntity(slot);
+    if (entity == EntityHandles::NULL_ENTITY) {
+      continue;
+    }
+    hash.value(slot);
+    hash.value(entity_handles.slotGeneration(slot));
+    // Only what the simulation decides with: components are hashed field by
+    // field, as their padding isn't guaranteed to be the same.
+    if (ecs.hasComponent<Position>(entity)) {
+      hash.value(ecs.getComponent<Position>(entity).p);
+    }
+    if (ecs.hasComponent<Velocity>(entity)) {
+      hash.value(ecs.getComponent<Velocity>(entity).v);
+    }
+    if (ecs.hasComponent<Health>(entity)) {
+      hash.value(ecs.getComponent<Health>(entity).current);
+    }
+    if (ecs.hasComponent<Destructible>(entity)) {
+      hash.value(ecs.getComponent<Destructible>(entity).rows);
+    }
+  }
+  serialiseState(hash);
+  return hash.digest();
+}
+
+void World::save(std::vector<std::byte> &snapshot) {
+  SnapshotWriter writer(snapshot, config.level);
+  saveEntities(writer, coordinator, entity_handles, texture_assets);
+  serialiseState(writer);
+  writer.finish();
+}
+
+bool World::restore(std::span<const std::byte> snapshot) {
+  auto reader = SnapshotReader::open(snapshot);
+  if (not reader.has_value() || reader->level() != config.level) {
+    return false;
+  }
+  // Checked in full before anything is replaced: the entities, then exactly
+  // enough left over for the rest of the state.
+  auto check = *reader;
+  SnapshotSize state_size;
+  serialiseState(state_size);
+  if (not validateEntities(check, texture_assets) ||
+      check.remaining() != state_size.size()) {
+    return false;
+  }
+  if (not restoreEntities(*reader, coordinator, entity_handles,
+                          texture_assets)) {
+    printf("Restored entities were reordered, so the game may not play out "
+           "exactly as before\n");
+  }
+  serialiseState(*reader);
+
+  score_changed = true;
+  invalidateDrawing();
+  return true;
+}
+
+void World::invalidateDrawing() {
+  destructibleRenderingSystem.invalidate();
+  for (size_t layer = 0; layer < N_LAYERS; ++layer) {
+    layerRenderingSystem.invalidate(static_cast<Layer>(layer));
+  }
+}
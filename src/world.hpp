@@ -0,0 +1,213 @@
+#ifndef GAME_WORLD_HPP
+#define GAME_WORLD_HPP
+
+#include "alien_movement_system.hpp"
+#include "allocation.hpp"
+#include "contacts.hpp"
+#include "draw_commands.hpp"
+#include "entity_handles.hpp"
+#include "game_event.hpp"
+#include "input.hpp"
+#include "particles.hpp"
+#include "pipeline.hpp"
+#include "prefab_data.hpp"
+#include "prefabs.hpp"
+#include "render_layers.hpp"
+#include "sounds.hpp"
+#include "systems.hpp"
+#include "texture_assets.hpp"
+#include <SDL2/SDL_render.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <tecs.hpp>
+#include <vector>
+
+using namespace Tecs;
+
+constexpr int WINDOW_WIDTH = 1280;
+constexpr int WINDOW_HEIGHT = 720;
+constexpr int N_BARRIERS = 4;
+constexpr size_t MAX_PARTICLES = 32 * 1024;
+
+// What a world draws & plays. Headless worlds leave everything null.
+struct WorldAssets {
+  SDL_Texture *player = nullptr;
+  std::array<SDL_Texture *, 3> aliens{};
+  // One each, as damage is drawn into them.
+  std::array<SDL_Texture *, N_BARRIERS> barriers{};
+  // The barrier sprite as ARGB8888. Its alpha decides which of a barrier's
+  // pixels are solid, so headless worlds should have it too.
+  SDL_Surface *barrier_image = nullptr;
+  SDL_Texture *bullet = nullptr;
+  SDL_Texture *enemy_bullet = nullptr;
+  SDL_Texture *mothership = nullptr;
+  Sounds sounds;
+  // What entities are made of, and how many aliens each level has. Needed by
+  // every world, headless or not.
+  const PrefabFile *prefabs = nullptr;
+};
+
+struct WorldConfig {
+  int width = WINDOW_WIDTH;
+  int height = WINDOW_HEIGHT;
+  int level = 1;
+  // Left at 0, the level's own from the prefab file.
+  int alien_rows = 0;
+  int alien_columns = 0;
+  float alien_speed = 0;
+  // Squeeze the aliens together to fit the window, however many there are.
+  bool fit_aliens = false;
+  // If set, another wave of aliens arrives at the top this often.
+  Duration wave_period = Duration::zero();
+  Duration player_fire_period = PlayerControlSystem::FIRE_FREQUENCY;
+  int enemy_fire_spacing = EnemyShootingSystem::FIRE_SPACING;
+  // Carried over from earlier levels.
+  uint32_t score = 0;
+  // Every RNG is seeded from this, so a level plays out the same way each time
+  // it is given the same inputs.
+  uint64_t seed = 0;
+  // Whether the world is drawn: headless worlds skip recording draw commands.
+  bool presented = true;
+  // Whether to pause briefly when the player is hit, which only makes sense
+  // when someone is watching in real time.
+  bool hit_stop = true;
+  // Nothing ends the level: the player can't be hurt, aliens that land are
+  // removed instead of ending the game, and the aliens neither speed up as
+  // they are destroyed nor win the level when cleared.
+  bool endless = false;
+};
+
+// One level of the game. A world holds all of its own state, so any number
+// can be simulated at once, on any threads.
+class World {
+public:
+  World(const WorldConfig &config, const WorldAssets &assets);
+  World(const World &) = delete;
+  World &operator=(const World &) = delete;
+
+  // Simulate a frame, and record its draw commands if presented. Only plays
+  // sounds through SDL, so can run off the main thread.
+  void simulate(const Input &frame_input, Duration delta);
+  // Apply the frame's events, returning GameOver or Win if the level is over,
+  // and Progress otherwise.
+  GameEvent finishFrame();
+  GameEvent step(const Input &frame_input, Duration delta) {
+    simulate(frame_input, delta);
+    return finishFrame();
+  }
+
+  [[nodiscard]] int level() const { return config.level; }
+  [[nodiscard]] uint32_t score() const { return player_score; }
+  // Whether the score changed in the last frame, or was restored.
+  [[nodiscard]] bool scoreChanged() const { return score_changed; }
+  // Frames simulated so far.
+  [[nodiscard]] uint64_t frame() const { return frame_number; }
+
+  Coordinator &ecs() { return coordinator; }
+  [[nodiscard]] const EntityHandles &handles() const { return entity_handles; }
+  [[nodiscard]] EntityHandle player() const { return player_handle; }
+  // Text entities. Rendering text is up to whoever presents the world.
+  [[nodiscard]] EntityHandle levelText() const { return level_text; }
+  [[nodiscard]] EntityHandle scoreText() const { return score_text; }
+
+  // The last frame's collisions, as resolved.
+  [[nodiscard]] const Contacts &contacts() const { return frame_contacts; }
+  DrawCommandBuffers &drawCommands() { return draw_commands; }
+  void invalidateLayer(Layer layer) { layerRenderingSystem.invalidate(layer); }
+  // Record every layer & destructible texture afresh in the next frame.
+  void invalidateDrawing();
+
+  // Summarises everything that decides how the level plays out, so runs that
+  // should be identical can be checked cheaply.
+  [[nodiscard]] uint64_t stateHash();
+
+  void save(std::vector<std::byte> &snapshot);
+  // Returns false, leaving the world as it was, if the snapshot isn't of this
+  // level or is damaged. Rendered text needs redrawing afterwards.
+  bool restore(std::span<const std::byte> snapshot);
+
+private:
+  WorldConfig config;
+  WorldAssets assets;
+  // Textures must be added in the same order every time, so their IDs in
+  // snapshots stay valid.
+  TextureAssets texture_assets;
+
+  // Backs the world's own containers, which are all freed at once with it.
+  std::pmr::monotonic_buffer_resource arena;
+  Coordinator coordinator;
+  bool components_registered;
+  EntityHandles entity_handles;
+  DrawCommandBuffers draw_commands;
+
+  // Scratch space for the current frame, reset as it finishes.
+  FrameArena frame_arena{std::pmr::new_delete_resource()};
+  GameEvents events;
+  Contacts frame_contacts;
+  Input input;
+  uint32_t player_score;
+  bool score_changed = true;
+  uint64_t frame_number = 0;
+
+  std::array<uint32_t, 3> seeds;
+  // Gives each alien's animation its own phase.
+  MersenneTwister alien_rng;
+  Duration wave_time = Duration::zero();
+  MersenneTwister mothership_rng;
+  bool mothership_active = false;
+  std::pmr::vector<Position> wave_positions;
+  std::pmr::vector<Entity> wave_aliens;
+
+  std::pmr::vector<EntityHandle> barriers;
+  // Explosion debris. Only drawn worlds have room for any.
+  ParticlePool particles;
+  EntityHandle player_handle;
+  EntityHandle level_text;
+  EntityHandle score_text;
+
+  Prefab player_prefab;
+  Prefab alien_prefab;
+  Prefab mothership_prefab;
+  Prefab bullet_prefab;
+  Prefab enemy_bullet_prefab;
+
+  VelocitySystem velocitySystem;
+  PlayerControlSystem playerControlSystem;
+  AlienMovementSystem alienMovementSystem;
+  // A system that simply queues an SDL_RenderCopy().
+  StaticSpriteRenderingSystem staticSpriteRenderingSystem;
+  AnimatedSpriteRenderingSystem animatedSpriteRenderingSystem;
+  HealthBarSystem healthBarSystem;
+  DeathSystem deathSystem;
+  LifeTimeSystem lifeTimeSystem;
+  EnemyShootingSystem enemyShootingSystem;
+  CollisionSystem collisionSystem;
+  AlienEncroachmentSystem alienEncroachmentSystem;
+  OffscreenSystem offscreenSystem;
+  // Redraws the barriers, border & text only when they change.
+  LayerRenderingSystem layerRenderingSystem;
+  DestructibleRenderingSystem destructibleRenderingSystem;
+
+  // Everything up to destroying entities, then everything that records draw
+  // commands. Destroyed entities are removed in between.
+  Pipeline<PlayerControlSystem, AlienMovementSystem, EnemyShootingSystem,
+           VelocitySystem, CollisionSystem, AlienEncroachmentSystem,
+           LifeTimeSystem, OffscreenSystem, DeathSystem>
+      simulationPipeline;
+  Pipeline<DestructibleRenderingSystem, LayerRenderingSystem,
+           StaticSpriteRenderingSystem, AnimatedSpriteRenderingSystem,
+           HealthBarSystem>
+      recordingPipeline;
+
+  void makeLevel();
+  void spawnAlienWave();
+  GameEvent applyEvents();
+  // Everything a snapshot needs besides the entities themselves. Only values
+  // laid out the same way in every build, as they are hashed too.
+  template <class Archive> void serialiseState(Archive &archive);
+};
+
+#endif // GAME_WORLD_HPP